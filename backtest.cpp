@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include "replay.h"
+#include "tick_store.h"
+
+// Parameter sweep over a recorded tick store
+// Every variant of a mean reversion strategy replays the whole store deterministically (replay.h),
+// variants run in parallel on all cores; the store's files are mapped once and only read by the
+// workers, each worker carves its variants' state out of its own arena, reset between variants
+// Usage:
+//   ./backtest DIR [--alphas N] [--thresholds N] [--top N] [--threads N]
+//       sweeps N moving average weights by N entry thresholds, prints the best variants by P&L
+
+constexpr int64_t markInterval = 1000000000; // Mark to market once a second of recorded time
+constexpr int64_t orderQuantity = 10;
+
+struct Variant {
+    double alpha;     // Weight of the newest price in the moving average
+    double threshold; // Relative distance from the average that trades
+};
+
+struct VariantResult {
+    double pnl = 0;
+    double maxDrawdown = 0;
+    uint64_t trades = 0;
+    uint64_t ticks = 0;
+};
+
+// State of one variant, every array comes from the worker's arena
+class MeanReversionBacktest {
+public:
+    MeanReversionBacktest(const Variant &variant, std::size_t symbols, std::pmr::memory_resource *arena)
+        : variant(variant), average(symbols, 0.0, arena), lastPrice(symbols, 0.0, arena),
+          position(symbols, 0, arena), ticks(symbols, 0, arena) {}
+
+    // Fills immediately at the tick price, like an immediate or cancel order against a deep book
+    void onTick(std::size_t symbol, const Tick &tick) {
+        lastPrice[symbol] = tick.price;
+        double &mean = average[symbol];
+        mean = ticks[symbol]++ == 0 ? tick.price : mean + variant.alpha * (tick.price - mean);
+        if (ticks[symbol] < 20) return; // Let the average warm up
+
+        double distance = (tick.price - mean) / mean;
+        if (std::fabs(distance) < variant.threshold) return;
+        int64_t side = distance > 0 ? -1 : 1;
+        position[symbol] += side * orderQuantity;
+        cash -= side * orderQuantity * tick.price;
+        ++result.trades;
+    }
+
+    void onTimer(int64_t) {
+        double equity = cash;
+        for (std::size_t i = 0; i < position.size(); ++i) equity += position[i] * lastPrice[i];
+        peak = std::max(peak, equity);
+        result.maxDrawdown = std::max(result.maxDrawdown, peak - equity);
+        result.pnl = equity;
+    }
+
+    const VariantResult &finish(uint64_t delivered) {
+        result.ticks = delivered;
+        return result;
+    }
+
+private:
+    Variant variant;
+    std::pmr::vector<double> average;
+    std::pmr::vector<double> lastPrice;
+    std::pmr::vector<int64_t> position;
+    std::pmr::vector<uint64_t> ticks;
+    double cash = 0;
+    double peak = 0;
+    VariantResult result;
+};
+
+// Per worker arena, the backing buffer is reused by every variant the worker runs
+struct WorkerArena {
+    std::vector<std::byte> buffer = std::vector<std::byte>(1 << 20);
+    std::pmr::monotonic_buffer_resource resource{buffer.data(), buffer.size()};
+};
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " DIR [--alphas N] [--thresholds N] [--top N] [--threads N]" << std::endl;
+        return 1;
+    }
+    std::string directory = argv[1];
+    std::size_t alphaSteps = 16, thresholdSteps = 16, top = 10;
+    std::size_t threads = std::thread::hardware_concurrency();
+    for (int i = 2; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--alphas") alphaSteps = std::stoull(argv[++i]);
+        else if (arg == "--thresholds") thresholdSteps = std::stoull(argv[++i]);
+        else if (arg == "--top") top = std::stoull(argv[++i]);
+        else if (arg == "--threads") threads = std::stoull(argv[++i]);
+    }
+    tbb::global_control parallelism(tbb::global_control::max_allowed_parallelism, threads);
+
+    // Alphas from 0.01 to 0.5, thresholds from 1 to 50 basis points, both on a log scale
+    std::vector<Variant> variants;
+    for (std::size_t a = 0; a < alphaSteps; ++a) {
+        for (std::size_t t = 0; t < thresholdSteps; ++t) {
+            double alpha = 0.01 * std::pow(50.0, alphaSteps > 1 ? double(a) / (alphaSteps - 1) : 0.0);
+            double threshold = 0.0001 * std::pow(50.0, thresholdSteps > 1 ? double(t) / (thresholdSteps - 1) : 0.0);
+            variants.push_back(Variant{alpha, threshold});
+        }
+    }
+
+    // Map every symbol up front, from here on the reader is only read
+    TickStoreReader reader(directory);
+    std::vector<std::string> symbols = reader.symbols();
+    for (const auto &symbol : symbols) {
+        std::size_t count;
+        reader.blockIndex(symbol, count);
+    }
+
+    std::vector<VariantResult> results(variants.size());
+    tbb::enumerable_thread_specific<WorkerArena> arenas;
+    auto start = std::chrono::steady_clock::now();
+    tbb::parallel_for(std::size_t(0), variants.size(), [&](std::size_t v) {
+        std::pmr::monotonic_buffer_resource &arena = arenas.local().resource;
+        arena.release();
+        MeanReversionBacktest backtest(variants[v], symbols.size(), &arena);
+        TickReplay replay(reader, symbols, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+        uint64_t delivered = replay.run(markInterval,
+            [&backtest](std::size_t symbol, const Tick &tick) { backtest.onTick(symbol, tick); },
+            [&backtest](int64_t now) { backtest.onTimer(now); });
+        results[v] = backtest.finish(delivered);
+    });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<std::size_t> order(variants.size());
+    for (std::size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&results](std::size_t a, std::size_t b) {
+        return results[a].pnl != results[b].pnl ? results[a].pnl > results[b].pnl : a < b;
+    });
+
+    uint64_t ticks = 0;
+    for (const auto &result : results) ticks += result.ticks;
+    std::cout << variants.size() << " variants over " << symbols.size() << " symbols in " << seconds << " s on "
+              << threads << " threads (" << ticks / seconds / 1e6 << "M ticks/s)" << std::endl;
+    std::cout << std::setw(10) << "alpha" << std::setw(12) << "threshold" << std::setw(10) << "trades"
+              << std::setw(16) << "pnl" << std::setw(16) << "max drawdown" << std::endl;
+    std::cout << std::fixed;
+    for (std::size_t i = 0; i < std::min(top, order.size()); ++i) {
+        const Variant &variant = variants[order[i]];
+        const VariantResult &result = results[order[i]];
+        std::cout << std::setprecision(4) << std::setw(10) << variant.alpha << std::setw(12) << variant.threshold
+                  << std::setw(10) << result.trades << std::setprecision(2) << std::setw(16) << result.pnl
+                  << std::setw(16) << result.maxDrawdown << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <emmintrin.h>
+
+#include "venue_codecs.h"
+
+// Consolidated best bid and offer across venues, NBBO style
+// Every symbol keeps each venue's last quote in venue indexed arrays, a quote update recomputes
+// the best bid and ask with a min/max over the arrays, the size at the best price is summed over
+// the venues quoting it
+// maxVenues lanes are four SSE2 registers per side, which is the x86-64 baseline and cheaper than
+// a dispatched call (cpu_dispatch.h) would be, so there is one version of the kernel
+// Single writer (the thread applying updates), the published quote of a symbol is a seqlock any
+// thread reads without scanning the venues
+
+constexpr std::size_t maxVenues = 8;
+
+struct ConsolidatedQuote {
+    double bid = 0.0;      // 0 when no venue bids
+    double ask = 0.0;      // 0 when no venue offers
+    int64_t bidSize = 0;   // Summed over the venues at the best bid
+    int64_t askSize = 0;
+    int64_t timestamp = 0; // Venue time of the update that last changed it
+};
+
+class QuoteConsolidator {
+public:
+    explicit QuoteConsolidator(std::size_t symbolCount) : books(symbolCount) {}
+
+    QuoteConsolidator(const QuoteConsolidator &) = delete;
+    QuoteConsolidator &operator=(const QuoteConsolidator &) = delete;
+
+    // Writer side: takes the quote part of update, returns true and the new consolidated quote in
+    // out only when the best bid, ask or their sizes changed
+    bool update(const MarketUpdate &update, ConsolidatedQuote &out) {
+        if (!(update.kind & MarketQuote) || update.symbol >= books.size() || update.venue >= maxVenues) return false;
+        Book &book = books[update.symbol];
+        std::size_t v = update.venue;
+        double ask = update.ask > 0.0 ? update.ask : noAsk;
+        int64_t bidSize = update.bid > 0.0 ? update.bidSize : 0;
+        int64_t askSize = update.ask > 0.0 ? update.askSize : 0;
+        if (book.bids[v] == update.bid && book.asks[v] == ask && book.bidSizes[v] == bidSize && book.askSizes[v] == askSize) {
+            return false; // The venue repeated its quote
+        }
+        book.bids[v] = update.bid;
+        book.asks[v] = ask;
+        book.bidSizes[v] = bidSize;
+        book.askSizes[v] = askSize;
+
+        ConsolidatedQuote next;
+        consolidate(book, next);
+        ConsolidatedQuote &current = book.current;
+        if (next.bid == current.bid && next.ask == current.ask && next.bidSize == current.bidSize && next.askSize == current.askSize) {
+            return false;
+        }
+        next.timestamp = update.timestamp;
+        current = next;
+        publish(book.published, next);
+        out = next;
+        return true;
+    }
+
+    // Reader side, any thread: the symbol's last published quote, false before the first one
+    bool quote(SymbolId symbol, ConsolidatedQuote &out) const {
+        if (symbol >= books.size()) return false;
+        const Published &published = books[symbol].published;
+        while (true) {
+            uint64_t before = published.stamp.load(std::memory_order_acquire);
+            if (before == 0) return false;
+            if (before & 1) continue; // Being written
+            out.bid = published.bid.load(std::memory_order_relaxed);
+            out.ask = published.ask.load(std::memory_order_relaxed);
+            out.bidSize = published.bidSize.load(std::memory_order_relaxed);
+            out.askSize = published.askSize.load(std::memory_order_relaxed);
+            out.timestamp = published.timestamp.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (published.stamp.load(std::memory_order_relaxed) == before) return true;
+        }
+    }
+
+private:
+    static constexpr double noAsk = std::numeric_limits<double>::infinity(); // Empty ask lane, never the minimum
+
+    // Stamp is odd while the writer updates the fields, 0 before the first quote
+    struct Published {
+        std::atomic<uint64_t> stamp{0};
+        std::atomic<double> bid{0.0};
+        std::atomic<double> ask{0.0};
+        std::atomic<int64_t> bidSize{0};
+        std::atomic<int64_t> askSize{0};
+        std::atomic<int64_t> timestamp{0};
+    };
+
+    // Venue lanes of one symbol, an empty bid is 0 and an empty ask noAsk, both with size 0
+    struct alignas(64) Book {
+        double bids[maxVenues] = {};
+        double asks[maxVenues] = {noAsk, noAsk, noAsk, noAsk, noAsk, noAsk, noAsk, noAsk};
+        int64_t bidSizes[maxVenues] = {};
+        int64_t askSizes[maxVenues] = {};
+        ConsolidatedQuote current;    // Writer's copy of the published quote
+        alignas(64) Published published; // Own line, readers don't share it with the lanes
+    };
+    static_assert(maxVenues == 8, "the kernel below is unrolled for 8 lanes");
+
+    // Best of the 8 lanes of prices, max for bids and min for asks, broadcast to both halves
+    template <bool Max>
+    static __m128d best(const double *prices) {
+        __m128d a = _mm_load_pd(prices), b = _mm_load_pd(prices + 2), c = _mm_load_pd(prices + 4), d = _mm_load_pd(prices + 6);
+        __m128d x = Max ? _mm_max_pd(_mm_max_pd(a, b), _mm_max_pd(c, d)) : _mm_min_pd(_mm_min_pd(a, b), _mm_min_pd(c, d));
+        __m128d swapped = _mm_shuffle_pd(x, x, 1);
+        return Max ? _mm_max_pd(x, swapped) : _mm_min_pd(x, swapped);
+    }
+
+    // Sum of the sizes of the lanes whose price equals the broadcast best
+    static int64_t sizeAt(__m128d bestPrice, const double *prices, const int64_t *sizes) {
+        __m128i sum = _mm_setzero_si128();
+        for (std::size_t i = 0; i < maxVenues; i += 2) {
+            __m128i at = _mm_castpd_si128(_mm_cmpeq_pd(_mm_load_pd(prices + i), bestPrice));
+            sum = _mm_add_epi64(sum, _mm_and_si128(at, _mm_load_si128(reinterpret_cast<const __m128i *>(sizes + i))));
+        }
+        sum = _mm_add_epi64(sum, _mm_unpackhi_epi64(sum, sum));
+        return _mm_cvtsi128_si64(sum);
+    }
+
+    static void consolidate(const Book &book, ConsolidatedQuote &out) {
+        __m128d bid = best<true>(book.bids);
+        __m128d ask = best<false>(book.asks);
+        out.bid = _mm_cvtsd_f64(bid);
+        out.ask = _mm_cvtsd_f64(ask);
+        out.bidSize = out.bid > 0.0 ? sizeAt(bid, book.bids, book.bidSizes) : 0;
+        out.askSize = out.ask != noAsk ? sizeAt(ask, book.asks, book.askSizes) : 0;
+        if (out.ask == noAsk) out.ask = 0.0;
+    }
+
+    static void publish(Published &published, const ConsolidatedQuote &quote) {
+        uint64_t stamp = published.stamp.load(std::memory_order_relaxed);
+        published.stamp.store(stamp + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        published.bid.store(quote.bid, std::memory_order_relaxed);
+        published.ask.store(quote.ask, std::memory_order_relaxed);
+        published.bidSize.store(quote.bidSize, std::memory_order_relaxed);
+        published.askSize.store(quote.askSize, std::memory_order_relaxed);
+        published.timestamp.store(quote.timestamp, std::memory_order_relaxed);
+        published.stamp.store(stamp + 2, std::memory_order_release);
+    }
+
+    std::vector<Book> books; // By symbol id, sized once
+};
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <immintrin.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include "cpu_dispatch.h"
+
+// Exponentially weighted covariance of a basket's returns, updated once per bar
+// With decay lambda and d = r - mean (the mean before this update):
+//     mean += (1 - lambda) d
+//     C     = lambda C + lambda (1 - lambda) d d'
+// The rank-1 update only touches the upper triangle, in blocks of rows that run in parallel on
+// the TBB pool; within a block the columns go in tiles so the tile of d stays in L1 for every row
+// of the block. The row kernel is vectorized, picked once through cpu_dispatch.h
+
+// row[j] = decay row[j] + scale d[j] for j < n
+inline void decayAddScalar(double *row, const double *d, std::size_t n, double decay, double scale) {
+    for (std::size_t j = 0; j < n; ++j) row[j] = decay * row[j] + scale * d[j];
+}
+
+// Multiply and add rather than FMA, the AVX2 level doesn't promise FMA
+__attribute__((target("avx2")))
+inline void decayAddAvx2(double *row, const double *d, std::size_t n, double decay, double scale) {
+    const __m256d decayVec = _mm256_set1_pd(decay), scaleVec = _mm256_set1_pd(scale);
+    std::size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m256d a = _mm256_loadu_pd(row + j), b = _mm256_loadu_pd(row + j + 4);
+        a = _mm256_add_pd(_mm256_mul_pd(decayVec, a), _mm256_mul_pd(scaleVec, _mm256_loadu_pd(d + j)));
+        b = _mm256_add_pd(_mm256_mul_pd(decayVec, b), _mm256_mul_pd(scaleVec, _mm256_loadu_pd(d + j + 4)));
+        _mm256_storeu_pd(row + j, a);
+        _mm256_storeu_pd(row + j + 4, b);
+    }
+    decayAddScalar(row + j, d + j, n - j, decay, scale);
+}
+
+__attribute__((target("avx512f")))
+inline void decayAddAvx512(double *row, const double *d, std::size_t n, double decay, double scale) {
+    const __m512d decayVec = _mm512_set1_pd(decay), scaleVec = _mm512_set1_pd(scale);
+    std::size_t j = 0;
+    for (; j + 8 <= n; j += 8) {
+        __m512d a = _mm512_mul_pd(decayVec, _mm512_loadu_pd(row + j));
+        _mm512_storeu_pd(row + j, _mm512_fmadd_pd(scaleVec, _mm512_loadu_pd(d + j), a));
+    }
+    if (j == n) return;
+    __mmask8 tail = static_cast<__mmask8>((1u << (n - j)) - 1);
+    __m512d a = _mm512_mul_pd(decayVec, _mm512_maskz_loadu_pd(tail, row + j));
+    _mm512_mask_storeu_pd(row + j, tail, _mm512_fmadd_pd(scaleVec, _mm512_maskz_loadu_pd(tail, d + j), a));
+}
+
+using DecayAddKernel = void (*)(double *, const double *, std::size_t, double, double);
+
+inline DecayAddKernel decayAddKernel() {
+    static const DecayAddKernel kernel = selectKernel(decayAddScalar, nullptr, decayAddAvx2, decayAddAvx512);
+    return kernel;
+}
+
+class EwCovariance {
+public:
+    static constexpr std::size_t rowBlock = 32;    // Rows per parallel task
+    static constexpr std::size_t columnTile = 512; // Doubles of d kept hot while a block's rows go by
+
+    EwCovariance(std::size_t n, double lambda) : n(n), lambda(lambda), matrix(n * n), mean(n), deviation(n) {}
+
+    // One bar's returns, returns[i] for basket member i
+    void update(const double *returns) {
+        for (std::size_t i = 0; i < n; ++i) {
+            deviation[i] = returns[i] - mean[i];
+            mean[i] += (1.0 - lambda) * deviation[i];
+        }
+        DecayAddKernel kernel = decayAddKernel();
+        const double weight = lambda * (1.0 - lambda);
+        std::size_t blocks = (n + rowBlock - 1) / rowBlock;
+        tbb::parallel_for(tbb::blocked_range<std::size_t>(0, blocks), [&](const tbb::blocked_range<std::size_t> &range) {
+            for (std::size_t block = range.begin(); block != range.end(); ++block) {
+                std::size_t first = block * rowBlock, last = std::min(first + rowBlock, n);
+                for (std::size_t tile = first; tile < n; tile += columnTile) {
+                    std::size_t tileEnd = std::min(tile + columnTile, n);
+                    for (std::size_t i = first; i < last; ++i) {
+                        std::size_t from = std::max(i, tile); // Upper triangle only
+                        if (from >= tileEnd) continue;
+                        kernel(&matrix[i * n + from], &deviation[from], tileEnd - from, lambda, weight * deviation[i]);
+                    }
+                }
+            }
+        });
+        ++updates;
+    }
+
+    double covariance(std::size_t i, std::size_t j) const { return i <= j ? matrix[i * n + j] : matrix[j * n + i]; }
+
+    // 0 while either member hasn't moved yet
+    double correlation(std::size_t i, std::size_t j) const {
+        double scale = std::sqrt(covariance(i, i) * covariance(j, j));
+        return scale > 0.0 ? covariance(i, j) / scale : 0.0;
+    }
+
+    // w' C w, the variance of one bar's return of a portfolio with these weights
+    double portfolioVariance(const double *weights) const {
+        double total = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            const double *row = &matrix[i * n];
+            double offDiagonal = 0.0;
+            for (std::size_t j = i + 1; j < n; ++j) offDiagonal += row[j] * weights[j];
+            total += weights[i] * (row[i] * weights[i] + 2.0 * offDiagonal);
+        }
+        return total;
+    }
+
+    std::size_t size() const { return n; }
+    uint64_t updateCount() const { return updates; }
+
+private:
+    std::size_t n;
+    double lambda;
+    std::vector<double> matrix; // Row major n x n, only the upper triangle is kept up to date
+    std::vector<double> mean;
+    std::vector<double> deviation;
+    uint64_t updates = 0;
+};
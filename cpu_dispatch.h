@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+// Runtime CPU feature dispatch
+// The binary is built for the generic x86-64 baseline, faster kernels are compiled with
+// __attribute__((target(...))) and picked once at startup from what CPUID reports
+// Set LOWLATENCY_CPU=baseline|sse42|avx2|avx512 to cap the level, e.g. to test a fallback
+
+enum class CpuLevel { Baseline = 0, Sse42 = 1, Avx2 = 2, Avx512 = 3 };
+
+inline const char *cpuLevelName(CpuLevel level) {
+    switch (level) {
+        case CpuLevel::Sse42: return "sse4.2";
+        case CpuLevel::Avx2: return "avx2";
+        case CpuLevel::Avx512: return "avx512";
+        default: return "baseline";
+    }
+}
+
+inline CpuLevel detectCpuLevel() {
+    __builtin_cpu_init();
+    CpuLevel level = CpuLevel::Baseline;
+    if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt")) level = CpuLevel::Sse42;
+    if (level == CpuLevel::Sse42 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi2")) level = CpuLevel::Avx2;
+    if (level == CpuLevel::Avx2 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+        __builtin_cpu_supports("avx512vl")) {
+        level = CpuLevel::Avx512;
+    }
+
+    if (const char *cap = std::getenv("LOWLATENCY_CPU")) {
+        CpuLevel limit = level;
+        if (std::strcmp(cap, "baseline") == 0) limit = CpuLevel::Baseline;
+        else if (std::strcmp(cap, "sse42") == 0) limit = CpuLevel::Sse42;
+        else if (std::strcmp(cap, "avx2") == 0) limit = CpuLevel::Avx2;
+        else if (std::strcmp(cap, "avx512") == 0) limit = CpuLevel::Avx512;
+        if (limit < level) level = limit;
+    }
+    return level;
+}
+
+// Detected once, every kernel table is built from the same answer
+inline CpuLevel cpuLevel() {
+    static const CpuLevel level = detectCpuLevel();
+    return level;
+}
+
+// Best implementation available at the current level, pass nullptr for levels a kernel
+// has no dedicated version for and the next lower one is used
+// Only the baseline argument deduces Fn, so the others can be plain nullptr
+template <typename Fn>
+Fn selectKernel(Fn baseline, std::common_type_t<Fn> sse42, std::common_type_t<Fn> avx2, std::common_type_t<Fn> avx512) {
+    CpuLevel level = cpuLevel();
+    if (level >= CpuLevel::Avx512 && avx512) return avx512;
+    if (level >= CpuLevel::Avx2 && avx2) return avx2;
+    if (level >= CpuLevel::Sse42 && sse42) return sse42;
+    return baseline;
+}
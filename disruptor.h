@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Sequenced ring with one producer and a graph of consumer stages (LMAX disruptor pattern)
+// Entries are preallocated and reused, the producer fills one in place and publishes its
+// sequence; every stage walks the same entries in order, no entry is copied or queued per stage
+// A stage may depend on other stages (a barrier): it only sees a sequence once all of them have
+// processed it, stages without dependencies follow the producer; the producer in turn never
+// overwrites an entry until every stage is done with it
+// Sequences start at 1, each stage runs on exactly one thread
+
+template <typename T, std::size_t Capacity>
+class Disruptor {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    class Stage {
+    public:
+        // Calls fn(T &entry, uint64_t seq, bool endOfBatch) for every entry its dependencies have
+        // released since the last call, then releases them itself; returns how many it saw
+        template <typename Fn>
+        std::size_t process(Fn &&fn) {
+            uint64_t next = done.load(std::memory_order_relaxed) + 1;
+            uint64_t available = ring.released(dependencies);
+            if (available < next) return 0;
+            for (uint64_t seq = next; seq <= available; ++seq) fn(ring.entry(seq), seq, seq == available);
+            done.store(available, std::memory_order_release);
+            return static_cast<std::size_t>(available - next + 1);
+        }
+
+        // Highest sequence this stage is done with
+        uint64_t processed() const { return done.load(std::memory_order_acquire); }
+
+    private:
+        friend class Disruptor;
+
+        Stage(Disruptor &ring, std::initializer_list<const Stage *> dependsOn) : ring(ring), dependencies(dependsOn) {}
+
+        Disruptor &ring;
+        std::vector<const Stage *> dependencies; // Empty: the producer
+        alignas(64) std::atomic<uint64_t> done{0};
+    };
+
+    Disruptor() : entries(Capacity) {}
+
+    Disruptor(const Disruptor&) = delete;
+    Disruptor& operator=(const Disruptor&) = delete;
+
+    // Add every stage before the producer and the stage threads start
+    Stage &addStage(std::initializer_list<const Stage *> dependsOn = {}) {
+        stages.emplace_back(new Stage(*this, dependsOn));
+        return *stages.back();
+    }
+
+    // Producer side: waits until the entry for the next sequence is free and returns it
+    // Publish at least once every Capacity claims, the stages only free entries they have seen
+    T &claim(uint64_t &seq) {
+        seq = claimed + 1;
+        while (seq > cachedGate + Capacity) {
+            cachedGate = released(gate());
+            if (seq > cachedGate + Capacity) std::this_thread::yield();
+        }
+        claimed = seq;
+        return entry(seq);
+    }
+
+    // Makes every claimed sequence up to seq visible to the stages
+    void publish(uint64_t seq) { cursor.store(seq, std::memory_order_release); }
+
+    uint64_t published() const { return cursor.load(std::memory_order_acquire); }
+
+    T &entry(uint64_t seq) { return entries[(seq - 1) & (Capacity - 1)]; }
+
+private:
+    // Highest sequence all of the given stages (or the producer, for none) have released
+    uint64_t released(const std::vector<const Stage *> &dependencies) const {
+        if (dependencies.empty()) return cursor.load(std::memory_order_acquire);
+        uint64_t lowest = ~uint64_t(0);
+        for (const Stage *stage : dependencies) lowest = std::min(lowest, stage->done.load(std::memory_order_acquire));
+        return lowest;
+    }
+
+    // Every stage gates the producer, the slowest one decides
+    const std::vector<const Stage *> &gate() {
+        if (gateStages.size() != stages.size()) {
+            gateStages.clear();
+            for (const auto &stage : stages) gateStages.push_back(stage.get());
+        }
+        return gateStages;
+    }
+
+    std::vector<T> entries;
+    std::vector<std::unique_ptr<Stage>> stages; // Stable addresses for the dependencies
+    alignas(64) std::atomic<uint64_t> cursor{0};
+    alignas(64) uint64_t claimed = 0;     // Producer only
+    uint64_t cachedGate = 0;              // Producer only, lowest stage sequence last seen
+    std::vector<const Stage *> gateStages;
+};
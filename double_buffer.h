@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Two copies of a value, one writer filling the back one while readers copy the front one
+// Readers announce themselves on the buffer they are about to read and recheck that it is still
+// front; the writer only ever writes the buffer that isn't front and skips a publish while a
+// reader still holds it, so neither side blocks (a skipped publish is caught up by the next)
+template <typename T>
+class DoubleBuffer {
+public:
+    DoubleBuffer() = default;
+    DoubleBuffer(const DoubleBuffer &) = delete;
+    DoubleBuffer &operator=(const DoubleBuffer &) = delete;
+
+    // Before the writer and readers start, fn(T &) runs on both buffers
+    template <typename Fn>
+    void initialize(Fn &&fn) {
+        fn(buffers[0]);
+        fn(buffers[1]);
+    }
+
+    // Writer side: fill(T &) writes the next contents into the back buffer, which then becomes
+    // front; false, without calling fill, while a reader still holds the back buffer
+    template <typename Fill>
+    bool publish(Fill &&fill) {
+        unsigned back = 1 - front.load(std::memory_order_seq_cst);
+        if (readers[back].load(std::memory_order_seq_cst) != 0) return false;
+        fill(buffers[back]);
+        front.store(back, std::memory_order_seq_cst);
+        return true;
+    }
+
+    // Reader side, any thread: returns read(const T &) run on the front buffer while it is held
+    template <typename Read>
+    auto read(Read &&read) const {
+        while (true) {
+            unsigned current = front.load(std::memory_order_seq_cst);
+            Hold hold{readers[current]};
+            if (front.load(std::memory_order_seq_cst) == current) return read(static_cast<const T &>(buffers[current]));
+        }
+    }
+
+private:
+    struct Hold {
+        std::atomic<uint32_t> &count;
+
+        explicit Hold(std::atomic<uint32_t> &count) : count(count) { count.fetch_add(1, std::memory_order_seq_cst); }
+        ~Hold() { count.fetch_sub(1, std::memory_order_release); }
+    };
+
+    T buffers[2];
+    alignas(64) std::atomic<unsigned> front{0};
+    alignas(64) mutable std::atomic<uint32_t> readers[2] = {};
+};
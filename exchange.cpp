@@ -0,0 +1,289 @@
+#include <iostream>
+#include <cstring>
+#include <csignal>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <sys/epoll.h>
+#include "order_book.h"
+#include "order_wire.h"
+#include "price_history.h"
+#include "socket_util.h"
+
+// Local matching engine standing in for an exchange
+// Runs price time priority matching per symbol, sends acks and executions to the owning
+// session and a market data update (last trade, top of book) to every session
+// Usage:
+//   ./exchange [address] [--flow ORDERS_PER_SEC] [--symbols N] [--mid PRICE]
+//       address is host:port or a Unix socket path; --flow adds random background orders
+//       on symbols 0..N-1 around PRICE so there is a market to trade against
+//   ./exchange --bench ORDERS   match ORDERS random orders in process and report throughput
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void handleSignal(int) {
+    stopRequested = 1;
+}
+
+constexpr uint64_t backgroundOwner = 0;        // Owner of the background flow's orders, not a session
+constexpr std::size_t maxBookSymbols = 1 << 16;
+constexpr std::size_t backgroundRestingLimit = 500; // Oldest background orders get cancelled past this
+
+struct Session {
+    int fd;
+    WireReader reader;
+    std::vector<char> outbound;
+};
+
+struct MatchingEngine {
+    std::vector<OrderBook> books;
+    std::unordered_map<int, std::unique_ptr<Session>> sessions;
+    uint64_t nextId = 1;
+    uint64_t orders = 0, trades = 0;
+
+    OrderBook *bookFor(uint32_t symbol) {
+        if (symbol >= maxBookSymbols) return nullptr;
+        if (symbol >= books.size()) books.resize(symbol + 1);
+        return &books[symbol];
+    }
+
+    Session *sessionFor(uint64_t owner) {
+        if (owner == backgroundOwner) return nullptr;
+        auto it = sessions.find(static_cast<int>(owner));
+        return it == sessions.end() ? nullptr : it->second.get();
+    }
+
+    void sendExecution(Session *session, WireMessageType type, uint32_t symbol, uint64_t orderId,
+                       int64_t quantity, int64_t price, int64_t leaves, int64_t now) {
+        if (!session) return;
+        WireExecution execution = makeWireMessage<WireExecution>(type);
+        execution.symbol = symbol;
+        execution.orderId = orderId;
+        execution.quantity = quantity;
+        execution.price = price;
+        execution.leavesQuantity = leaves;
+        execution.exchangeTime = now;
+        appendWireMessage(session->outbound, execution);
+    }
+
+    // Match one order; owner is a session fd or backgroundOwner, clientId is echoed back
+    // Returns the exchange id when the order rests in the book, 0 otherwise
+    uint64_t submit(uint64_t owner, uint64_t clientId, uint32_t symbol, int side, int64_t price,
+                    int64_t quantity, TimeInForce timeInForce, int64_t now) {
+        OrderBook &book = *bookFor(symbol);
+        Session *taker = sessionFor(owner);
+        int64_t bidBefore = book.bestBid(), askBefore = book.bestAsk();
+        int64_t lastPrice = 0, lastQuantity = 0, leaves = quantity;
+        uint64_t id = nextId++;
+        ++orders;
+
+        leaves = book.add(id, owner, clientId, side, price, quantity, timeInForce,
+            [&](const OrderBook::RestingOrder &maker, int64_t tradePrice, int64_t traded) {
+                leaves -= traded;
+                lastPrice = tradePrice;
+                lastQuantity += traded;
+                ++trades;
+                sendExecution(sessionFor(maker.owner), WireExecutionType, symbol, maker.tag, traded, tradePrice, maker.quantity, now);
+                sendExecution(taker, WireExecutionType, symbol, clientId, traded, tradePrice, leaves, now);
+            });
+        bool rested = leaves > 0 && timeInForce == TimeInForce::Day;
+        if (leaves > 0 && !rested) sendExecution(taker, WireCancelledType, symbol, clientId, leaves, price, 0, now);
+
+        if (lastQuantity > 0 || book.bestBid() != bidBefore || book.bestAsk() != askBefore) {
+            publish(symbol, book, lastPrice, lastQuantity, now);
+        }
+        return rested ? id : 0;
+    }
+
+    void cancel(uint32_t symbol, uint64_t id, int64_t now) {
+        OrderBook &book = books[symbol];
+        int64_t bidBefore = book.bestBid(), askBefore = book.bestAsk();
+        OrderBook::RestingOrder cancelled;
+        if (!book.cancel(id, cancelled)) return;
+        sendExecution(sessionFor(cancelled.owner), WireCancelledType, symbol, cancelled.tag, cancelled.quantity, cancelled.price, 0, now);
+        if (book.bestBid() != bidBefore || book.bestAsk() != askBefore) publish(symbol, book, 0, 0, now);
+    }
+
+    // Pull the resting orders of a session that went away, its fd can come back as a new session
+    // whose client ids start over; call after the session is erased
+    void cancelSession(int fd, int64_t now) {
+        for (uint32_t symbol = 0; symbol < books.size(); ++symbol) {
+            OrderBook &book = books[symbol];
+            int64_t bidBefore = book.bestBid(), askBefore = book.bestAsk();
+            if (book.cancelOwner(static_cast<uint64_t>(fd)) == 0) continue;
+            if (book.bestBid() != bidBefore || book.bestAsk() != askBefore) publish(symbol, book, 0, 0, now);
+        }
+    }
+
+    void publish(uint32_t symbol, const OrderBook &book, int64_t lastPrice, int64_t lastQuantity, int64_t now) {
+        if (sessions.empty()) return;
+        WireMarketData update = makeWireMessage<WireMarketData>(WireMarketDataType);
+        update.symbol = symbol;
+        update.lastPrice = lastPrice;
+        update.lastQuantity = lastQuantity;
+        update.bestBid = book.bestBid();
+        update.bestAsk = book.bestAsk();
+        update.exchangeTime = now;
+        for (auto &entry : sessions) appendWireMessage(entry.second->outbound, update);
+    }
+};
+
+// Random orders around a drifting mid so sessions have liquidity and trades to react to
+struct BackgroundFlow {
+    std::mt19937_64 rng{42};
+    std::vector<int64_t> mids;
+    std::vector<std::deque<uint64_t>> resting;
+
+    BackgroundFlow(std::size_t symbols, double mid) : mids(symbols, priceToWire(mid)), resting(symbols) {}
+
+    void step(MatchingEngine &engine, int64_t now) {
+        uint32_t symbol = static_cast<uint32_t>(rng() % mids.size());
+        int side = (rng() & 1) ? 1 : -1;
+        int64_t tick = priceToWire(0.01);
+        // Mostly passive, sometimes crossing by a few ticks
+        int64_t offset = (static_cast<int64_t>(rng() % 12) - 3) * tick;
+        int64_t price = mids[symbol] - side * offset;
+        int64_t quantity = static_cast<int64_t>(rng() % 100) + 1;
+        uint64_t id = engine.submit(backgroundOwner, 0, symbol, side, price, quantity, TimeInForce::Day, now);
+        if (id) resting[symbol].push_back(id);
+        if (resting[symbol].size() > backgroundRestingLimit) {
+            engine.cancel(symbol, resting[symbol].front(), now);
+            resting[symbol].pop_front();
+        }
+
+        // Follow the book so the mid drifts with the trades
+        const OrderBook &book = engine.books[symbol];
+        if (book.bestBid() && book.bestAsk()) mids[symbol] = (book.bestBid() + book.bestAsk()) / 2;
+    }
+};
+
+// Turn every complete order of a session into matching work, replies are queued on outbound
+bool handleOrders(MatchingEngine &engine, Session &session) {
+    return session.reader.forEachMessage([&](const WireHeader &header, const char *message) {
+        if (header.type != WireNewOrderType) return;
+        WireNewOrder order;
+        std::memcpy(&order, message, sizeof(order));
+        int64_t now = wallClockNanos();
+
+        bool valid = order.quantity > 0 && order.price > 0 && (order.side == 1 || order.side == -1) &&
+                     order.timeInForce <= 1 && engine.bookFor(order.symbol) != nullptr;
+        WireAck ack = makeWireMessage<WireAck>(valid ? WireAckType : WireRejectType);
+        ack.reason = valid ? 0 : 1;
+        ack.orderId = order.orderId;
+        ack.sendTime = order.sendTime;
+        ack.exchangeTime = now;
+        appendWireMessage(session.outbound, ack);
+        if (valid) {
+            engine.submit(static_cast<uint64_t>(session.fd), order.orderId, order.symbol, order.side, order.price,
+                          order.quantity, static_cast<TimeInForce>(order.timeInForce), now);
+        }
+    });
+}
+
+// Match orders random orders over a few symbols with no I/O and report the throughput
+int runBenchmark(std::size_t orders) {
+    constexpr std::size_t symbols = 64;
+    MatchingEngine engine;
+    engine.books.resize(symbols);
+    BackgroundFlow flow(symbols, 100.0);
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < orders; ++i) flow.step(engine, static_cast<int64_t>(i));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "Matched " << engine.orders << " orders, " << engine.trades << " trades in " << seconds << " s: "
+              << static_cast<double>(engine.orders) / seconds / 1e6 << " million orders per second" << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    std::string address = defaultExchangeAddress;
+    double flowRate = 0.0, mid = 100.0;
+    std::size_t flowSymbols = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bench" && i + 1 < argc) return runBenchmark(std::stoull(argv[++i]));
+        else if (arg == "--flow" && i + 1 < argc) flowRate = std::stod(argv[++i]);
+        else if (arg == "--symbols" && i + 1 < argc) flowSymbols = std::stoull(argv[++i]);
+        else if (arg == "--mid" && i + 1 < argc) mid = std::stod(argv[++i]);
+        else address = arg;
+    }
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    MatchingEngine engine;
+    BackgroundFlow flow(flowSymbols, mid);
+    engine.books.resize(flowSymbols);
+
+    int listener = listenOn(address);
+    setNonBlocking(listener);
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listener, &event);
+    std::cout << "Exchange listening on " << address << std::endl;
+
+    epoll_event events[64];
+    auto flowStart = std::chrono::steady_clock::now();
+    uint64_t flowSent = 0;
+    while (!stopRequested) {
+        int ready = epoll_wait(epollFd, events, 64, flowRate > 0 ? 1 : 100);
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listener) {
+                int client;
+                while ((client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    setNoDelay(client);
+                    epoll_event clientEvent{};
+                    clientEvent.events = EPOLLIN;
+                    clientEvent.data.fd = client;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, client, &clientEvent);
+                    engine.sessions[client] = std::make_unique<Session>(Session{client, WireReader(), {}});
+                    std::cout << "Exchange: session " << client << " connected" << std::endl;
+                }
+                continue;
+            }
+
+            Session &session = *engine.sessions[fd];
+            if (!session.reader.readFrom(fd) || !handleOrders(engine, session)) {
+                std::cout << "Exchange: session " << fd << " closed" << std::endl;
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+                ::close(fd);
+                engine.sessions.erase(fd);
+                engine.cancelSession(fd, wallClockNanos());
+            }
+        }
+
+        if (flowRate > 0) {
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - flowStart).count();
+            int64_t now = wallClockNanos();
+            for (; flowSent < static_cast<uint64_t>(elapsed * flowRate); ++flowSent) flow.step(engine, now);
+        }
+
+        // One write per session for everything produced in this pass
+        for (auto it = engine.sessions.begin(); it != engine.sessions.end();) {
+            Session &session = *it->second;
+            if (!session.outbound.empty() && !writeAll(session.fd, session.outbound.data(), session.outbound.size())) {
+                std::cout << "Exchange: session " << session.fd << " closed" << std::endl;
+                int fd = session.fd;
+                ::close(fd);
+                it = engine.sessions.erase(it);
+                engine.cancelSession(fd, wallClockNanos());
+                continue;
+            }
+            session.outbound.clear();
+            ++it;
+        }
+    }
+
+    for (auto &entry : engine.sessions) ::close(entry.first);
+    ::close(listener);
+    ::close(epollFd);
+    if (!isTcpAddress(address)) ::unlink(address.c_str());
+    return 0;
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <immintrin.h>
+
+#include "cpu_dispatch.h"
+#include "options.h"
+
+// Implied volatility of whole chains at once, the inverse of options.h's pricing
+// Every contract starts from the Corrado-Miller closed form guess and takes Newton steps on the
+// model price, kept inside a bracket [lo, hi] that each evaluation narrows (the price rises with
+// volatility); a step that would leave the bracket bisects instead, so far out of the money
+// contracts with next to no vega still converge
+// The vector kernels run one contract per lane and stop updating a lane once it converged, a
+// group ends when all its lanes did
+// Puts are solved as calls through put-call parity; a price outside the no arbitrage bounds has
+// no volatility and gives NaN, as does one within the tolerance of a bound, which any volatility
+// from next to nothing up would match
+
+constexpr double minImpliedVol = 1e-4;
+constexpr double maxImpliedVol = 5.0;
+constexpr double impliedVolTolerance = 1e-12; // Of the model price, relative to spot
+constexpr int maxImpliedVolIterations = 32;
+
+// Columns of the quotes to solve, n contracts
+struct ImpliedVolBatch {
+    const double *strike;
+    const double *expiry; // Years since the epoch
+    const double *call;   // 1 for a call, 0 for a put
+    const double *price;  // Quoted option price
+    double *volatility;   // Out
+    std::size_t n;
+};
+
+inline void impliedVolScalar(const ImpliedVolBatch &batch, double spot, double rate, double now) {
+    using namespace bsconst;
+    const double tolerance = impliedVolTolerance * spot;
+    for (std::size_t i = 0; i < batch.n; ++i) {
+        double years = std::max(batch.expiry[i] - now, minYearsToExpiry);
+        double rootYears = std::sqrt(years);
+        double discounted = batch.strike[i] * expApprox(-rate * years);
+        double target = batch.price[i] + (1.0 - batch.call[i]) * (spot - discounted); // As a call
+        double forwardGap = spot - discounted;
+        if (!(target > std::max(forwardGap, 0.0) + tolerance && target < spot - tolerance)) {
+            batch.volatility[i] = std::numeric_limits<double>::quiet_NaN();
+            continue;
+        }
+        double logMoneyness = logApprox(spot / batch.strike[i]);
+
+        // Corrado-Miller
+        double middle = target - 0.5 * forwardGap;
+        double root = std::sqrt(std::max(middle * middle - forwardGap * forwardGap / M_PI, 0.0));
+        double vol = std::sqrt(2.0 * M_PI / years) / (spot + discounted) * (middle + root);
+        vol = std::min(std::max(vol, minImpliedVol), maxImpliedVol);
+
+        double lo = minImpliedVol, hi = maxImpliedVol;
+        for (int iteration = 0; iteration < maxImpliedVolIterations; ++iteration) {
+            double volRoot = vol * rootYears;
+            double d1 = (logMoneyness + (rate + 0.5 * vol * vol) * years) / volRoot;
+            double diff = spot * normalCdfApprox(d1) - discounted * normalCdfApprox(d1 - volRoot) - target;
+            if (std::abs(diff) <= tolerance) break;
+            if (diff > 0.0) hi = vol;
+            else lo = vol;
+            double vega = spot * expApprox(-0.5 * d1 * d1) * invSqrt2Pi * rootYears;
+            double next = vol - diff / vega;
+            vol = next > lo && next < hi ? next : 0.5 * (lo + hi);
+            if (hi - lo <= 1e-12) break;
+        }
+        batch.volatility[i] = vol;
+    }
+}
+
+__attribute__((target("avx2")))
+inline void impliedVolAvx2(const ImpliedVolBatch &batch, double spot, double rate, double now) {
+    using namespace bsconst;
+    const __m256d spotVec = _mm256_set1_pd(spot), rateVec = _mm256_set1_pd(rate), nowVec = _mm256_set1_pd(now);
+    const __m256d zero = _mm256_setzero_pd(), half = _mm256_set1_pd(0.5), one = _mm256_set1_pd(1.0);
+    const __m256d tolerance = _mm256_set1_pd(impliedVolTolerance * spot), signBit = _mm256_set1_pd(-0.0);
+    std::size_t i = 0;
+    for (; i + 4 <= batch.n; i += 4) {
+        __m256d years = _mm256_max_pd(_mm256_sub_pd(_mm256_loadu_pd(batch.expiry + i), nowVec), _mm256_set1_pd(minYearsToExpiry));
+        __m256d rootYears = _mm256_sqrt_pd(years);
+        __m256d strike = _mm256_loadu_pd(batch.strike + i);
+        __m256d discounted = _mm256_mul_pd(strike, expAvx2(_mm256_sub_pd(zero, _mm256_mul_pd(rateVec, years))));
+        __m256d forwardGap = _mm256_sub_pd(spotVec, discounted);
+        __m256d put = _mm256_sub_pd(one, _mm256_loadu_pd(batch.call + i));
+        __m256d target = _mm256_add_pd(_mm256_loadu_pd(batch.price + i), _mm256_mul_pd(put, forwardGap));
+        __m256d valid = _mm256_and_pd(_mm256_cmp_pd(target, _mm256_add_pd(_mm256_max_pd(forwardGap, zero), tolerance), _CMP_GT_OQ),
+                                      _mm256_cmp_pd(target, _mm256_sub_pd(spotVec, tolerance), _CMP_LT_OQ));
+        __m256d logMoneyness = logAvx2(_mm256_div_pd(spotVec, strike));
+
+        __m256d middle = _mm256_sub_pd(target, _mm256_mul_pd(half, forwardGap));
+        __m256d squared = _mm256_sub_pd(_mm256_mul_pd(middle, middle), _mm256_mul_pd(_mm256_mul_pd(forwardGap, forwardGap), _mm256_set1_pd(1.0 / M_PI)));
+        __m256d root = _mm256_sqrt_pd(_mm256_max_pd(squared, zero));
+        __m256d vol = _mm256_mul_pd(_mm256_div_pd(_mm256_sqrt_pd(_mm256_div_pd(_mm256_set1_pd(2.0 * M_PI), years)), _mm256_add_pd(spotVec, discounted)),
+                                    _mm256_add_pd(middle, root));
+        vol = _mm256_min_pd(_mm256_max_pd(vol, _mm256_set1_pd(minImpliedVol)), _mm256_set1_pd(maxImpliedVol));
+
+        __m256d lo = _mm256_set1_pd(minImpliedVol), hi = _mm256_set1_pd(maxImpliedVol);
+        __m256d active = valid;
+        for (int iteration = 0; iteration < maxImpliedVolIterations && _mm256_movemask_pd(active); ++iteration) {
+            __m256d volRoot = _mm256_mul_pd(vol, rootYears);
+            __m256d drift = _mm256_mul_pd(_mm256_add_pd(rateVec, _mm256_mul_pd(half, _mm256_mul_pd(vol, vol))), years);
+            __m256d d1 = _mm256_div_pd(_mm256_add_pd(logMoneyness, drift), volRoot);
+            __m256d model = _mm256_sub_pd(_mm256_mul_pd(spotVec, normalCdfAvx2(d1)), _mm256_mul_pd(discounted, normalCdfAvx2(_mm256_sub_pd(d1, volRoot))));
+            __m256d diff = _mm256_sub_pd(model, target);
+            active = _mm256_andnot_pd(_mm256_cmp_pd(_mm256_andnot_pd(signBit, diff), tolerance, _CMP_LE_OQ), active);
+            __m256d above = _mm256_cmp_pd(diff, zero, _CMP_GT_OQ);
+            hi = _mm256_blendv_pd(hi, vol, _mm256_and_pd(active, above));
+            lo = _mm256_blendv_pd(lo, vol, _mm256_andnot_pd(above, active));
+            __m256d density = _mm256_mul_pd(expAvx2(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(d1, d1))), _mm256_set1_pd(invSqrt2Pi));
+            __m256d vega = _mm256_mul_pd(_mm256_mul_pd(spotVec, density), rootYears);
+            __m256d next = _mm256_sub_pd(vol, _mm256_div_pd(diff, vega));
+            __m256d inside = _mm256_and_pd(_mm256_cmp_pd(next, lo, _CMP_GT_OQ), _mm256_cmp_pd(next, hi, _CMP_LT_OQ));
+            next = _mm256_blendv_pd(_mm256_mul_pd(half, _mm256_add_pd(lo, hi)), next, inside);
+            vol = _mm256_blendv_pd(vol, next, active);
+            active = _mm256_and_pd(active, _mm256_cmp_pd(_mm256_sub_pd(hi, lo), _mm256_set1_pd(1e-12), _CMP_GT_OQ));
+        }
+        _mm256_storeu_pd(batch.volatility + i, _mm256_blendv_pd(_mm256_set1_pd(std::numeric_limits<double>::quiet_NaN()), vol, valid));
+    }
+    ImpliedVolBatch tail = batch;
+    tail.strike += i, tail.expiry += i, tail.call += i, tail.price += i, tail.volatility += i;
+    tail.n -= i;
+    impliedVolScalar(tail, spot, rate, now);
+}
+
+// GCC 12 flags the deliberately undefined source operand inside its own AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f")))
+inline void impliedVolAvx512(const ImpliedVolBatch &batch, double spot, double rate, double now) {
+    using namespace bsconst;
+    const __m512d spotVec = _mm512_set1_pd(spot), rateVec = _mm512_set1_pd(rate), nowVec = _mm512_set1_pd(now);
+    const __m512d zero = _mm512_setzero_pd(), half = _mm512_set1_pd(0.5), one = _mm512_set1_pd(1.0);
+    const __m512d tolerance = _mm512_set1_pd(impliedVolTolerance * spot);
+    for (std::size_t i = 0; i < batch.n; i += 8) {
+        // The last group runs masked, lanes past n are invalid quotes and never iterate
+        __mmask8 lanes = batch.n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (batch.n - i)) - 1);
+        __m512d years = _mm512_max_pd(_mm512_sub_pd(_mm512_mask_loadu_pd(_mm512_add_pd(nowVec, one), lanes, batch.expiry + i), nowVec),
+                                      _mm512_set1_pd(minYearsToExpiry));
+        __m512d rootYears = _mm512_sqrt_pd(years);
+        __m512d strike = _mm512_mask_loadu_pd(spotVec, lanes, batch.strike + i);
+        __m512d discounted = _mm512_mul_pd(strike, expAvx512(_mm512_sub_pd(zero, _mm512_mul_pd(rateVec, years))));
+        __m512d forwardGap = _mm512_sub_pd(spotVec, discounted);
+        __m512d put = _mm512_sub_pd(one, _mm512_mask_loadu_pd(one, lanes, batch.call + i));
+        __m512d target = _mm512_fmadd_pd(put, forwardGap, _mm512_maskz_loadu_pd(lanes, batch.price + i));
+        __mmask8 valid = lanes & _mm512_cmp_pd_mask(target, _mm512_add_pd(_mm512_max_pd(forwardGap, zero), tolerance), _CMP_GT_OQ) &
+                         _mm512_cmp_pd_mask(target, _mm512_sub_pd(spotVec, tolerance), _CMP_LT_OQ);
+        __m512d logMoneyness = logAvx512(_mm512_mul_pd(spotVec, reciprocalAvx512(strike)));
+
+        __m512d middle = _mm512_fnmadd_pd(half, forwardGap, target);
+        __m512d squared = _mm512_fnmadd_pd(_mm512_mul_pd(forwardGap, forwardGap), _mm512_set1_pd(1.0 / M_PI), _mm512_mul_pd(middle, middle));
+        __m512d root = _mm512_sqrt_pd(_mm512_max_pd(squared, zero));
+        __m512d scale = _mm512_mul_pd(_mm512_sqrt_pd(_mm512_mul_pd(_mm512_set1_pd(2.0 * M_PI), reciprocalAvx512(years))),
+                                      reciprocalAvx512(_mm512_add_pd(spotVec, discounted)));
+        __m512d vol = _mm512_mul_pd(scale, _mm512_add_pd(middle, root));
+        vol = _mm512_min_pd(_mm512_max_pd(vol, _mm512_set1_pd(minImpliedVol)), _mm512_set1_pd(maxImpliedVol));
+
+        __m512d lo = _mm512_set1_pd(minImpliedVol), hi = _mm512_set1_pd(maxImpliedVol);
+        __mmask8 active = valid;
+        for (int iteration = 0; iteration < maxImpliedVolIterations && active; ++iteration) {
+            __m512d volRoot = _mm512_mul_pd(vol, rootYears);
+            __m512d drift = _mm512_mul_pd(_mm512_fmadd_pd(half, _mm512_mul_pd(vol, vol), rateVec), years);
+            __m512d d1 = _mm512_mul_pd(_mm512_add_pd(logMoneyness, drift), reciprocalAvx512(volRoot));
+            __m512d model = _mm512_fnmadd_pd(discounted, normalCdfAvx512(_mm512_sub_pd(d1, volRoot)), _mm512_mul_pd(spotVec, normalCdfAvx512(d1)));
+            __m512d diff = _mm512_sub_pd(model, target);
+            active &= _mm512_cmp_pd_mask(_mm512_abs_pd(diff), tolerance, _CMP_GT_OQ);
+            __mmask8 above = _mm512_cmp_pd_mask(diff, zero, _CMP_GT_OQ);
+            hi = _mm512_mask_mov_pd(hi, active & above, vol);
+            lo = _mm512_mask_mov_pd(lo, active & ~above, vol);
+            __m512d density = _mm512_mul_pd(expAvx512(_mm512_mul_pd(_mm512_set1_pd(-0.5), _mm512_mul_pd(d1, d1))), _mm512_set1_pd(invSqrt2Pi));
+            __m512d vega = _mm512_mul_pd(_mm512_mul_pd(spotVec, density), rootYears);
+            __m512d next = _mm512_div_pd(diff, vega); // A true divide, vega can be subnormal far from the money
+            next = _mm512_sub_pd(vol, next);
+            __mmask8 inside = _mm512_cmp_pd_mask(next, lo, _CMP_GT_OQ) & _mm512_cmp_pd_mask(next, hi, _CMP_LT_OQ);
+            next = _mm512_mask_blend_pd(inside, _mm512_mul_pd(half, _mm512_add_pd(lo, hi)), next);
+            vol = _mm512_mask_mov_pd(vol, active, next);
+            active &= _mm512_cmp_pd_mask(_mm512_sub_pd(hi, lo), _mm512_set1_pd(1e-12), _CMP_GT_OQ);
+        }
+        _mm512_mask_storeu_pd(batch.volatility + i, lanes,
+                              _mm512_mask_blend_pd(valid, _mm512_set1_pd(std::numeric_limits<double>::quiet_NaN()), vol));
+    }
+}
+#pragma GCC diagnostic pop
+
+using ImpliedVolKernel = void (*)(const ImpliedVolBatch &, double, double, double);
+
+inline ImpliedVolKernel impliedVolKernel() {
+    static const ImpliedVolKernel kernel = selectKernel(impliedVolScalar, nullptr, impliedVolAvx2, impliedVolAvx512);
+    return kernel;
+}
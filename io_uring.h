@@ -0,0 +1,172 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Minimal io_uring over the raw system calls (no liburing dependency)
+// One thread owns the ring: it fills submission entries with nextEntry(), hands them to the
+// kernel and waits for completions in the same io_uring_enter call, then walks the completions
+// with forEachCompletion(); also sets up sparse fixed file tables and provided buffer rings
+
+class IoUring {
+public:
+    // entries submission slots, completionEntries completion slots (0: twice entries)
+    // The ring starts disabled so it can be set up on one thread and run on another: the thread
+    // that calls enable() becomes its single issuer
+    explicit IoUring(unsigned entries, unsigned completionEntries = 0) {
+        io_uring_params params{};
+        params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_SUBMIT_ALL |
+                       IORING_SETUP_R_DISABLED;
+        if (completionEntries) {
+            params.flags |= IORING_SETUP_CQSIZE;
+            params.cq_entries = completionEntries;
+        }
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) throw std::runtime_error(std::string("io_uring_setup: ") + std::strerror(errno));
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+            ::close(fd);
+            throw std::runtime_error("io_uring: kernel too old (needs single mmap and extended arguments)");
+        }
+
+        ringSize = std::max(params.sq_off.array + params.sq_entries * sizeof(uint32_t),
+                            params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+        ring = ::mmap(nullptr, ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        entriesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqes = ::mmap(nullptr, entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+        if (ring == MAP_FAILED || sqes == MAP_FAILED) {
+            ::close(fd);
+            throw std::runtime_error("io_uring: cannot map the rings");
+        }
+        auto *base = static_cast<char *>(ring);
+        sqHead = reinterpret_cast<std::atomic<uint32_t> *>(base + params.sq_off.head);
+        sqTail = reinterpret_cast<std::atomic<uint32_t> *>(base + params.sq_off.tail);
+        sqMask = *reinterpret_cast<uint32_t *>(base + params.sq_off.ring_mask);
+        sqEntries = params.sq_entries;
+        submissions = static_cast<io_uring_sqe *>(sqes);
+        // Identity mapping, entries are consumed in the order they are filled
+        auto *array = reinterpret_cast<uint32_t *>(base + params.sq_off.array);
+        for (uint32_t i = 0; i < sqEntries; ++i) array[i] = i;
+        cqHead = reinterpret_cast<std::atomic<uint32_t> *>(base + params.cq_off.head);
+        cqTail = reinterpret_cast<std::atomic<uint32_t> *>(base + params.cq_off.tail);
+        cqMask = *reinterpret_cast<uint32_t *>(base + params.cq_off.ring_mask);
+        completions = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+        localTail = sqTail->load(std::memory_order_relaxed);
+    }
+
+    ~IoUring() {
+        ::munmap(submissions, entriesSize);
+        ::munmap(ring, ringSize);
+        ::close(fd);
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Start the ring from the thread that will submit to it from now on
+    void enable() {
+        registerOrThrow(IORING_REGISTER_ENABLE_RINGS, nullptr, 0, "enable");
+    }
+
+    // Free submission entry, cleared; submits what is queued first when the ring is full
+    io_uring_sqe &nextEntry() {
+        if (localTail - sqHead->load(std::memory_order_acquire) == sqEntries) submitAndWait(0, -1);
+        io_uring_sqe &entry = submissions[localTail & sqMask];
+        std::memset(&entry, 0, sizeof(entry));
+        ++localTail;
+        return entry;
+    }
+
+    // Submit everything queued and wait for at least waitFor completions or timeoutNanos
+    // (negative: no timeout), one system call; returns false on a timeout or a signal
+    bool submitAndWait(unsigned waitFor, int64_t timeoutNanos) {
+        uint32_t toSubmit = localTail - sqTail->load(std::memory_order_relaxed);
+        sqTail->store(localTail, std::memory_order_release);
+        __kernel_timespec timeout{timeoutNanos / 1000000000, timeoutNanos % 1000000000};
+        io_uring_getevents_arg arg{};
+        arg.ts = timeoutNanos >= 0 ? reinterpret_cast<uint64_t>(&timeout) : 0;
+        // Always GETEVENTS, with deferred task running completions are only posted inside it
+        unsigned flags = IORING_ENTER_EXT_ARG | IORING_ENTER_GETEVENTS;
+        ++calls;
+        long rc = ::syscall(__NR_io_uring_enter, fd, toSubmit, waitFor, flags, &arg, sizeof(arg));
+        if (rc < 0 && errno != ETIME && errno != EINTR && errno != EBUSY) {
+            throw std::runtime_error(std::string("io_uring_enter: ") + std::strerror(errno));
+        }
+        return rc >= 0;
+    }
+
+    // Calls fn(const io_uring_cqe &) for every completion available, returns how many
+    template <typename Fn>
+    unsigned forEachCompletion(Fn &&fn) {
+        uint32_t head = cqHead->load(std::memory_order_relaxed);
+        uint32_t tail = cqTail->load(std::memory_order_acquire);
+        for (uint32_t i = head; i != tail; ++i) fn(static_cast<const io_uring_cqe &>(completions[i & cqMask]));
+        cqHead->store(tail, std::memory_order_release);
+        return tail - head;
+    }
+
+    // Table of count fixed files, all empty; entries take file_index / IOSQE_FIXED_FILE slots
+    void registerSparseFiles(unsigned count) {
+        io_uring_rsrc_register table{};
+        table.nr = count;
+        table.flags = IORING_RSRC_REGISTER_SPARSE;
+        registerOrThrow(IORING_REGISTER_FILES2, &table, sizeof(table), "fixed files");
+    }
+
+    // Put fd in slot (fd -1 empties the slot, dropping the ring's reference to the file)
+    void updateFile(unsigned slot, int fileFd) {
+        io_uring_files_update update{};
+        update.offset = slot;
+        update.fds = reinterpret_cast<uint64_t>(&fileFd);
+        ++calls;
+        if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_FILES_UPDATE, &update, 1) < 0) {
+            throw std::runtime_error(std::string("io_uring fixed file update: ") + std::strerror(errno));
+        }
+    }
+
+    // Register the provided buffer ring at ring (page aligned, entries * sizeof(io_uring_buf))
+    void registerBufferRing(io_uring_buf_ring *bufferRing, unsigned entries, unsigned group) {
+        io_uring_buf_reg reg{};
+        reg.ring_addr = reinterpret_cast<uint64_t>(bufferRing);
+        reg.ring_entries = entries;
+        reg.bgid = static_cast<uint16_t>(group);
+        registerOrThrow(IORING_REGISTER_PBUF_RING, &reg, 1, "buffer ring");
+    }
+
+    // io_uring_enter and io_uring_register calls so far
+    uint64_t systemCalls() const { return calls; }
+
+private:
+    void registerOrThrow(unsigned opcode, void *arg, unsigned count, const char *what) {
+        ++calls;
+        if (::syscall(__NR_io_uring_register, fd, opcode, arg, count) < 0) {
+            throw std::runtime_error(std::string("io_uring register ") + what + ": " + std::strerror(errno));
+        }
+    }
+
+    int fd = -1;
+    void *ring = nullptr;
+    std::size_t ringSize = 0;
+    std::size_t entriesSize = 0;
+    io_uring_sqe *submissions = nullptr;
+    io_uring_cqe *completions = nullptr;
+    std::atomic<uint32_t> *sqHead = nullptr;
+    std::atomic<uint32_t> *sqTail = nullptr;
+    std::atomic<uint32_t> *cqHead = nullptr;
+    std::atomic<uint32_t> *cqTail = nullptr;
+    uint32_t sqMask = 0;
+    uint32_t sqEntries = 0;
+    uint32_t cqMask = 0;
+    uint32_t localTail = 0; // Filled but not yet handed to the kernel
+    uint64_t calls = 0;
+};
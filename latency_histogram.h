@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Log linear histogram of nanosecond latencies, 16 sub buckets per power of two
+// so percentiles are within ~6% of the true value; single threaded, no allocation
+class LatencyHistogram {
+public:
+    void record(int64_t nanos) {
+        uint64_t v = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+        ++buckets[bucketOf(v)];
+        ++total;
+        largest = std::max(largest, v);
+        sum += v;
+    }
+
+    // Latency at percentile p in [0, 100], the upper edge of the bucket it falls in
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p / 100.0 * static_cast<double>(total - 1)) + 1;
+        uint64_t seen = 0;
+        for (std::size_t b = 0; b < bucketCount; ++b) {
+            seen += buckets[b];
+            if (seen >= rank) return std::min(upperEdge(b), largest);
+        }
+        return largest;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return largest; }
+    double mean() const { return total ? static_cast<double>(sum) / static_cast<double>(total) : 0.0; }
+
+    void reset() {
+        std::memset(buckets, 0, sizeof(buckets));
+        total = largest = sum = 0;
+    }
+
+private:
+    static constexpr std::size_t subBuckets = 16;
+    static constexpr std::size_t bucketCount = 64 * subBuckets;
+
+    static std::size_t bucketOf(uint64_t v) {
+        if (v < subBuckets) return static_cast<std::size_t>(v);
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(v));
+        std::size_t sub = static_cast<std::size_t>((v >> (msb - 4)) & (subBuckets - 1));
+        return (msb - 3) * subBuckets + sub;
+    }
+
+    static uint64_t upperEdge(std::size_t bucket) {
+        if (bucket < subBuckets) return bucket;
+        unsigned msb = static_cast<unsigned>(bucket / subBuckets) + 3;
+        uint64_t sub = bucket % subBuckets;
+        return ((subBuckets + sub + 1) << (msb - 4)) - 1;
+    }
+
+    uint64_t buckets[bucketCount] = {};
+    uint64_t total = 0;
+    uint64_t largest = 0;
+    uint64_t sum = 0;
+};
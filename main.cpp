@@ -1,34 +1,117 @@
 #include <iostream>
+#include <limits>
 #include <atomic>
 #include <vector>
 #include <string>
 #include <thread>
 #include <chrono>
 #include <random>
+#include <csignal>
+#include <memory>
+#include <type_traits>
+#include <cmath>
+#include <algorithm>
+#include <functional>
+#include <string_view>
 #include <tbb/concurrent_hash_map.h> // Intel TBB for lock-free hash map
-#include <tbb/concurrent_queue.h>   // For batch updates
 #include <tbb/global_control.h>
+#include "movers.h"
+#include "price_history.h"
+#include "price_triggers.h"
+#include "replay.h"
+#include "tick_broadcast.h"
+#include "text_codec.h"
+#include "tick_store.h"
+#include "consolidated_quote.h"
+#include "covariance.h"
+#include "cpu_dispatch.h"
+#include "disruptor.h"
+#include "symbol_hash.h"
+#include "symbols.h"
+#include "risk_check.h"
+#include "spsc_ring.h"
+#include "implied_vol.h"
+#include "options.h"
+#include "order_gateway.h"
+#include "query_server.h"
+#include "uring_query_server.h"
+#include "venue_codecs.h"
+#include "websocket_protocol.h"
+#include "strategy.h"
+#include "strategy_plugin.h"
+
+// Number of past updates each symbol keeps for time travel queries
+constexpr std::size_t priceHistoryDepth = 64;
 
 // Use atomic, thread safe
 struct StockData {
     std::atomic<double> price;
+    SymbolId id = invalidSymbol;
+    PriceHistory<priceHistoryDepth> history; // last updates, newest overwrites oldest
 
     StockData() : price(0.0) {}
-    StockData(double initialPrice) : price(initialPrice) {}
+    StockData(double initialPrice, SymbolId id) : price(initialPrice), id(id) {}
 
     // Maintain atomic thread safety for move assignment   
     StockData& operator=(StockData&& other) noexcept {
         price.store(other.price.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        id = other.id;
         return *this;
     }
 
     // Delete so we don't accidentally copy atomic variables
     StockData& operator=(const StockData&) = delete;
+
+    // Publish a new price and append it to the history ring, single writer per symbol
+    void update(double newPrice, int64_t timestamp) {
+        price.store(newPrice, std::memory_order_relaxed);
+        history.record(newPrice, timestamp);
+    }
 };
 
 // Use lock free hash map for data
 // Use Intel TBB concurrent_hash_map to reduce contention and avoid traditional mutex based locking
-tbb::concurrent_hash_map<std::string, StockData> stockPrices;
+// Symbols are hashed with the CRC32C kernel when the CPU has SSE4.2
+using StockPriceMap = tbb::concurrent_hash_map<std::string, StockData, SymbolHashCompare>;
+StockPriceMap stockPrices;
+
+// Dense ids of the listed symbols, and each symbol's slot in stockPrices by id
+// Map nodes never move, so hot paths that work on ids read the atomic price through these pointers
+SymbolTable symbols;
+std::vector<StockData *> stockSlots;
+
+// Cleared by Ctrl + c so the threads can finish and the tick store gets flushed
+std::atomic<bool> running{true};
+
+// Set by --record, every applied update is appended to this tick store
+std::unique_ptr<TickStoreWriter> recorder;
+
+// Set by --broadcast, every applied update is published to other processes through this ring
+std::unique_ptr<TickBroadcastWriter> broadcaster;
+
+// Venue feed formats the process reads, each normalized to MarketUpdate before it is applied
+// Created once the symbols are listed; each feed is only decoded by one thread
+using MarketFeeds = MarketDataNormalizer<ExchangeFeed, ItchFeed, SbeFeed>;
+std::unique_ptr<MarketFeeds> marketFeeds;
+static_assert(MarketFeeds::venueCount <= maxVenues, "a venue lane per feed");
+
+// Best bid and offer across the venues, kept by the thread applying updates and readable from any
+// Created with marketFeeds
+std::unique_ptr<QuoteConsolidator> consolidatedQuotes;
+
+void handleSignal(int) {
+    running.store(false, std::memory_order_relaxed);
+}
+
+// Slot of a symbol, listing it at price first if it is new, call before the threads start
+StockData &listSymbol(const std::string &name, double price) {
+    StockPriceMap::accessor accessor;
+    if (stockPrices.insert(accessor, name)) {
+        accessor->second = StockData(price, symbols.intern(name));
+        stockSlots.push_back(&accessor->second);
+    }
+    return accessor->second;
+}
 
 // Random number generator for stock prices
 double generateRandomPrice(double base, double range) {
@@ -37,48 +120,445 @@ double generateRandomPrice(double base, double range) {
     return dist(rng);
 }
 
-// Do batch updates in a single operation for efficiency and to reduce contention
-void simulateBatchUpdates() {
-    std::vector<std::string> stocks = {"AAPL", "GOOGL", "AMZN", "MSFT", "TSLA"};
-    while (true) {
-        auto start_time = std::chrono::high_resolution_clock::now(); // Start timer
+// Toy strategy: on every tick send a small immediate or cancel order, alternating sides, at the
+// consolidated offer for buys and bid for sells, or at the tick's price while that side is empty
+// Runs on the thread that applies prices, which in gateway mode is also the ring's consumer
+struct FollowTickStrategy : Strategy<FollowTickStrategy> {
+    OrderRing *orders = nullptr;
+    int32_t side = 1;
+    int64_t position = 0;
+    QuoteEvent quote{}; // Last consolidated quote, of the one subscribed symbol
 
-        tbb::concurrent_queue<std::pair<std::string, double>> updateQueue;
+    void onQuote(const QuoteEvent &event) { quote = event; }
 
-        for (const auto &stock : stocks) {
-            double newPrice = generateRandomPrice(100.0, 50.0); // Generate random price
-            updateQueue.push({stock, newPrice});
+    void onTick(const TickEvent &tick) {
+        if (!orders) return;
+        double touch = side > 0 ? quote.ask : quote.bid;
+        Order order{0, 0, tick.symbol, side, 10, touch > 0.0 ? touch : tick.price, 0};
+        if (orders->tryPush(OutboundOrder{order, tick.timestamp, TimeInForce::ImmediateOrCancel})) side = -side;
+    }
+
+    void onFill(const FillEvent &fill) { position += fill.side * fill.quantity; }
+};
+
+// Prints one line per closed bar
+struct BarPrinterStrategy : Strategy<BarPrinterStrategy> {
+    void onBar(const Bar &bar) {
+        line.assign("Bar ").append(symbols.name(bar.symbol)).append(" open ");
+        appendDouble(line, bar.open, 6);
+        line.append(" high ");
+        appendDouble(line, bar.high, 6);
+        line.append(" low ");
+        appendDouble(line, bar.low, 6);
+        line.append(" close ");
+        appendDouble(line, bar.close, 6);
+        line.append(" ticks ");
+        appendInteger(line, bar.ticks);
+        std::cout << line << std::endl;
+    }
+
+    std::string line; // Reused, formatting goes through text_codec.h rather than the stream
+};
+
+// Decay of the risk covariance per bar, RiskMetrics' daily value
+constexpr double riskLambda = 0.94;
+
+// Collects a basket's bar closes and hands each interval's log returns to the risk thread, which
+// keeps their covariance (covariance.h) off the thread applying prices
+struct RiskStrategy : Strategy<RiskStrategy> {
+    using ReturnRing = SpscRing<std::vector<double>, 16>;
+
+    ReturnRing *returns = nullptr;
+    std::vector<int32_t> member;  // Basket position by symbol id, -1 outside the basket
+    std::vector<double> closes;   // Last close by basket position, carried over intervals without a bar
+    std::vector<double> previous; // Closes of the interval before
+    std::vector<double> row;      // Scratch, reused so the ring copies without allocating
+    int64_t intervalEnd = 0;      // End of the bars being collected, 0 when none is
+    uint64_t dropped = 0;
+
+    void onBar(const Bar &bar) {
+        if (bar.symbol >= member.size() || member[bar.symbol] < 0) return;
+        if (intervalEnd && bar.end > intervalEnd) flush(intervalEnd); // A later interval started
+        closes[member[bar.symbol]] = bar.close;
+        intervalEnd = bar.end;
+    }
+
+    // After the engine's timer closed every bar ending by now, the interval is complete
+    void flush(int64_t now) {
+        if (!intervalEnd || intervalEnd > now) return;
+        intervalEnd = 0;
+        bool first = previous.empty();
+        row.resize(closes.size());
+        for (std::size_t i = 0; i < closes.size(); ++i) {
+            row[i] = !first && previous[i] > 0.0 && closes[i] > 0.0 ? std::log(closes[i] / previous[i]) : 0.0;
         }
+        previous = closes;
+        if (!first && !returns->tryPush(row)) ++dropped;
+    }
+};
+
+// Every strategy type the process can run, dispatched without virtual calls
+StrategyEngine<FollowTickStrategy, BarPrinterStrategy, PluginStrategy, RiskStrategy> strategies;
+
+// Ring the plugin strategy's orders go to, null without a gateway
+OrderRing *pluginOrders = nullptr;
+
+// Top 50 gainers, losers and most active, kept by the thread applying prices and published to
+// dashboard readers once per batch
+MoversTracker movers(50);
+
+// Option chains listed with --options, repriced on every tick of their underlying
+OptionBook optionBook(0.03);
+std::vector<long> watchedOption; // By symbol id, the contract queryStockPrice prints, -1 for none
 
-        std::pair<std::string, double> update;
-        while (updateQueue.try_pop(update)) {
-            tbb::concurrent_hash_map<std::string, StockData>::accessor accessor;
-            if (stockPrices.find(accessor, update.first)) {
-                accessor->second.price.store(update.second, std::memory_order_relaxed);
+// A made up chain around spot: 12 monthly expiries, strikes from half to one and a half times spot
+// in 2.5% steps, calls and puts, with a volatility smile; returns the first expiry's at the money call
+std::size_t listSyntheticChain(SymbolId underlying, double spot, int64_t now) {
+    constexpr int64_t nanosPerDay = 86400 * int64_t(1000000000);
+    std::vector<OptionContract> contracts;
+    std::size_t atTheMoney = 0;
+    for (int month = 1; month <= 12; ++month) {
+        for (int step = -20; step <= 20; ++step) {
+            double moneyness = 1.0 + 0.025 * step;
+            for (bool call : {true, false}) {
+                if (month == 1 && step == 0 && call) atTheMoney = contracts.size();
+                double smile = 0.25 + 0.4 * (moneyness - 1.0) * (moneyness - 1.0);
+                contracts.push_back(OptionContract{spot * moneyness, now + month * 30 * nanosPerDay, smile, call});
             }
         }
+    }
+    optionBook.list(underlying, contracts);
+    return atTheMoney;
+}
 
-        auto end_time = std::chrono::high_resolution_clock::now(); // End timer
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
-        std::cout << "Batch update latency: " << duration << " microseconds" << std::endl;
+// Set by --alert and --stop, fired on the thread applying prices
+struct TriggerAction {
+    int32_t side;         // Of the stop order, 1 buy (rising) or -1 sell (falling)
+    int64_t stopQuantity; // 0 for an alert
+};
+TriggerIndex<TriggerAction> triggers;
+
+// Ring stop orders go to, null without a gateway
+OrderRing *stopOrders = nullptr;
+
+void fireTriggers(SymbolId symbol, double price, int64_t timestamp) {
+    triggers.onPrice(symbol, price, [&](uint64_t id, double level, const TriggerAction &action) {
+        std::string line(action.stopQuantity ? "Stop " : "Alert ");
+        appendInteger(line, id);
+        line.append(" ").append(symbols.name(symbol)).append(" crossed ");
+        appendDouble(line, level);
+        line.append(" at ");
+        appendDouble(line, price);
+        std::cout << line << std::endl;
+        if (!action.stopQuantity || !stopOrders) return;
+        // Goes out immediate or cancel at the price that triggered it
+        Order order{0, 0, symbol, action.side, action.stopQuantity, price, 0};
+        if (!stopOrders->tryPush(OutboundOrder{order, timestamp, TimeInForce::ImmediateOrCancel})) std::cout << "Stop order ring full" << std::endl;
+    });
+}
+
+// SYMBOL>LEVEL or SYMBOL<LEVEL, with :QUANTITY after it for a stop order
+bool addTrigger(const std::string &spec, bool stop) {
+    std::size_t op = spec.find_first_of("<>");
+    std::size_t colon = spec.find(':', op == std::string::npos ? 0 : op);
+    if (op == std::string::npos || stop != (colon != std::string::npos)) return false;
+    SymbolId symbol = symbols.find(spec.substr(0, op));
+    const char *levelEnd = spec.data() + (stop ? colon : spec.size());
+    double level;
+    int64_t quantity = 0;
+    if (symbol == invalidSymbol || !parseDouble(spec.data() + op + 1, levelEnd, level)) return false;
+    if (stop && (!parseInteger(levelEnd + 1, spec.data() + spec.size(), quantity) || quantity <= 0)) return false;
+    bool rising = spec[op] == '>';
+    triggers.add(symbol, rising ? TriggerDirection::Rising : TriggerDirection::Falling, level, TriggerAction{rising ? 1 : -1, quantity});
+    return true;
+}
+
+int sendPluginOrder(void *, const PluginOrder *order, int64_t tickTimestamp) {
+    if (!pluginOrders) return -1;
+    Order next{0, 0, order->symbol, order->side, order->quantity, order->price, 0};
+    TimeInForce timeInForce = order->timeInForce == 1 ? TimeInForce::ImmediateOrCancel : TimeInForce::Day;
+    return pluginOrders->tryPush(OutboundOrder{next, tickTimestamp, timeInForce}) ? 0 : -1;
+}
+
+void logPluginMessage(void *, const char *message) {
+    std::cout << "Strategy: " << message << std::endl;
+}
+
+// SIGHUP swaps in the plugin library again from its path at the next batch boundary
+void handleReloadSignal(int) {
+    strategies.get<PluginStrategy>().requestReload();
+}
+
+// Runs after each batch of updates, on the thread that applies them
+void endBatch(int64_t now) {
+    movers.publish();
+    strategies.onTimer(now);
+    if (strategies.get<RiskStrategy>().returns) strategies.get<RiskStrategy>().flush(now);
+    strategies.get<PluginStrategy>().onBatchEnd();
+}
+
+// The apply step alone: the symbol's slot and the strategies, only the thread that owns price
+// updates may call this
+void applyToSlot(StockData &slot, double price, int64_t timestamp) {
+    slot.update(price, timestamp);
+    movers.onPrice(slot.id, price);
+    optionBook.onPrice(slot.id, price, timestamp);
+    strategies.onTick(TickEvent{slot.id, price, timestamp});
+    fireTriggers(slot.id, price, timestamp);
+}
+
+// Apply one price update and journal and publish it on the same thread
+void applyPriceUpdate(StockData &slot, double price, int64_t timestamp) {
+    applyToSlot(slot, price, timestamp);
+    if (recorder) recorder->append(symbols.name(slot.id), timestamp, price);
+    if (broadcaster) broadcaster->publish(slot.id, price, timestamp);
+}
+
+// The quote step for a normalized update: the venue's quote goes into the consolidated one, the
+// strategies hear about it only when the consolidated quote changed
+void applyQuote(const MarketUpdate &update) {
+    ConsolidatedQuote quote;
+    if (!consolidatedQuotes->update(update, quote)) return;
+    strategies.onQuote(QuoteEvent{update.symbol, quote.bid, quote.ask, quote.bidSize, quote.askSize, quote.timestamp});
+}
+
+// The apply step for a normalized update, only trades move the price
+void applyMarketUpdate(const MarketUpdate &update) {
+    applyQuote(update);
+    if (update.kind & MarketTrade) applyToSlot(*stockSlots[update.symbol], update.price, update.timestamp);
+}
+
+// One entry of the update pipeline, filled once by the generator and read in place by every stage
+struct PipelineUpdate {
+    MarketUpdate update;
+    bool lastInBatch;
+};
+
+// Update flow of the random batch updates:
+//     generate -> journal
+//              -> apply -> analytics
+//                       -> publish
+// journal and apply run in parallel on the same entries, analytics and publish wait for apply
+using UpdatePipeline = Disruptor<PipelineUpdate, 1024>;
+
+// Runs one stage on the calling thread until the generator stopped and the stage is drained
+template <typename Fn>
+void runStage(const std::atomic<bool> &generatorDone, UpdatePipeline &pipeline, UpdatePipeline::Stage &stage, Fn fn) {
+    while (true) {
+        bool done = generatorDone.load(std::memory_order_acquire);
+        if (stage.process(fn) > 0) continue;
+        if (done && stage.processed() == pipeline.published()) return;
+        std::this_thread::yield();
+    }
+}
+
+// Instrument code of a symbol on a simulated venue, each venue numbers them its own way
+template <typename Feed>
+uint32_t simulatedCode(SymbolId id) {
+    if (std::is_same<Feed, ItchFeed>::value) return id + 1;         // Locate codes start at 1
+    if (std::is_same<Feed, SbeFeed>::value) return 300000000 + id; // Security ids, any 32 bit value
+    return id;
+}
+
+// Sends the venue's definition messages for the simulated symbols through its feed
+template <typename Feed>
+void defineSimulatedSymbols(const std::vector<SymbolId> &stocks, std::vector<char> &bytes) {
+    bytes.clear();
+    for (SymbolId id : stocks) VenueCodec<Feed>::encodeDefinition(simulatedCode<Feed>(id), symbols.name(id), bytes);
+    marketFeeds->decode<Feed>(bytes.data(), bytes.size(), [](const MarketUpdate &) {});
+}
+
+// Encodes a batch the way Feed's venue sends it, decodes it back through the normalizer into the
+// pipeline and publishes the whole batch at once
+template <typename Feed>
+void publishSimulatedBatch(UpdatePipeline &pipeline, const std::vector<MarketUpdate> &batch, std::vector<char> &bytes) {
+    bytes.clear();
+    for (const MarketUpdate &update : batch) VenueCodec<Feed>::encode(update, simulatedCode<Feed>(update.symbol), bytes);
+    uint64_t seq = 0;
+    PipelineUpdate *last = nullptr;
+    marketFeeds->decode<Feed>(bytes.data(), bytes.size(), [&](const MarketUpdate &update) {
+        last = &pipeline.claim(seq);
+        *last = PipelineUpdate{update, false};
+    });
+    if (!last) return;
+    last->lastInBatch = true; // Not visible to the stages before the publish
+    pipeline.publish(seq);
+}
+
+// Do batch updates in a single operation for efficiency and to reduce contention
+void simulateBatchUpdates() {
+    std::vector<SymbolId> stocks;
+    for (const char *stock : {"AAPL", "GOOGL", "AMZN", "MSFT", "TSLA"}) stocks.push_back(symbols.find(stock));
+
+    UpdatePipeline pipeline;
+    UpdatePipeline::Stage &journal = pipeline.addStage();
+    UpdatePipeline::Stage &apply = pipeline.addStage();
+    UpdatePipeline::Stage &analytics = pipeline.addStage({&apply});
+    UpdatePipeline::Stage &publish = pipeline.addStage({&apply});
+    std::atomic<bool> generatorDone{false};
+
+    std::thread journalThread([&] {
+        runStage(generatorDone, pipeline, journal, [](PipelineUpdate &entry, uint64_t, bool) {
+            const MarketUpdate &update = entry.update;
+            if (recorder && (update.kind & MarketTrade)) recorder->append(symbols.name(update.symbol), update.timestamp, update.price);
+        });
+    });
+    std::thread applyThread([&] {
+        runStage(generatorDone, pipeline, apply, [](PipelineUpdate &entry, uint64_t, bool) {
+            applyMarketUpdate(entry.update);
+            if (entry.lastInBatch) endBatch(entry.update.timestamp);
+        });
+    });
+    std::thread analyticsThread([&] {
+        runStage(generatorDone, pipeline, analytics, [](PipelineUpdate &entry, uint64_t, bool) {
+            if (!entry.lastInBatch) return;
+            // Generated to applied, the batch's timestamp is taken when it is generated
+            std::cout << "Batch update latency: " << (wallClockNanos() - entry.update.timestamp) / 1000 << " microseconds" << std::endl;
+        });
+    });
+    std::thread publishThread([&] {
+        runStage(generatorDone, pipeline, publish, [](PipelineUpdate &entry, uint64_t, bool) {
+            const MarketUpdate &update = entry.update;
+            if (broadcaster && (update.kind & MarketTrade)) broadcaster->publish(update.symbol, update.price, update.timestamp);
+        });
+    });
+
+    // Each batch arrives as the bytes of one venue's feed, the venues take turns
+    std::vector<char> bytes;
+    defineSimulatedSymbols<ItchFeed>(stocks, bytes);
+    defineSimulatedSymbols<SbeFeed>(stocks, bytes);
+    std::vector<MarketUpdate> batch(stocks.size());
+    for (std::size_t venue = 0; running.load(std::memory_order_relaxed); ++venue) {
+        int64_t timestamp = wallClockNanos();
+        for (std::size_t i = 0; i < stocks.size(); ++i) {
+            double price = generateRandomPrice(100.0, 50.0);
+            batch[i] = MarketUpdate{stocks[i], 0, MarketTrade | MarketQuote, 0, timestamp, price, 100, price - 0.01, price + 0.01, 500, 500};
+        }
+        switch (venue % MarketFeeds::venueCount) {
+        case 0: publishSimulatedBatch<ExchangeFeed>(pipeline, batch, bytes); break;
+        case 1: publishSimulatedBatch<ItchFeed>(pipeline, batch, bytes); break;
+        default: publishSimulatedBatch<SbeFeed>(pipeline, batch, bytes); break;
+        }
 
         std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Simulate latency
     }
+    generatorDone.store(true, std::memory_order_release);
+    journalThread.join();
+    applyThread.join();
+    analyticsThread.join();
+    publishThread.join();
+}
+
+// Price of a stock as it was at time t (nanoseconds since epoch), answered from the history ring
+bool queryStockPriceAsOf(const std::string &stock, int64_t t, PriceTick &out) {
+    StockPriceMap::const_accessor accessor;
+    return stockPrices.find(accessor, stock) && accessor->second.history.priceAsOf(t, out);
+}
+
+// Copy the last n ticks of a stock into out, oldest first, returns how many were copied
+std::size_t queryRecentTicks(const std::string &stock, std::size_t n, PriceTick *out) {
+    StockPriceMap::const_accessor accessor;
+    if (!stockPrices.find(accessor, stock)) return 0;
+    return accessor->second.history.lastTicks(n, out);
+}
+
+// Live price of a symbol by id, 0 for an unknown id
+double lastStockPrice(SymbolId id) {
+    return id < stockSlots.size() ? stockSlots[id]->price.load(std::memory_order_relaxed) : 0.0;
+}
+
+// Run the pre trade checks for an order against the live price slot of its symbol
+uint32_t checkOrder(RiskEngine &risk, const Order &order) {
+    return risk.check(order, lastStockPrice(order.symbol));
+}
+
+// Exchange market data drives the prices when running against the matching engine
+// Called on the gateway thread, which is then the only price writer
+void applyMarketData(const WireMarketData &message) {
+    MarketUpdate update;
+    if (!VenueCodec<ExchangeFeed>::normalize(message, marketFeeds->feed<ExchangeFeed>().symbolMap(), update)) return;
+    applyQuote(update);
+    if (update.kind & MarketTrade) applyPriceUpdate(*stockSlots[update.symbol], update.price, update.timestamp);
+}
+
+// Hooks the order gateway calls on its own thread
+struct GatewayHooks {
+    static double lastPrice(SymbolId id) { return lastStockPrice(id); }
+    static void onMarketData(const WireMarketData &update) { applyMarketData(update); }
+    static void onBatchEnd(int64_t now) { endBatch(now); }
+    static void onFill(const Order &order, int64_t quantity, double price, int64_t timestamp) {
+        strategies.onFill(FillEvent{order.symbol, order.orderId, order.side, quantity, price, timestamp});
+    }
+};
+
+// Implied volatilities of a whole chain from its current prices, as a vol surface feed would get
+// them, and a line with the at the money one of the watched contract's expiry, which should give
+// back the volatility it was priced at
+void solveVolSurface(const std::string &stock, SymbolId id, long watched, std::string &line) {
+    thread_local std::vector<double> prices, vols;
+    std::size_t chain = static_cast<std::size_t>(optionBook.chainIndex(id));
+    double spot;
+    int64_t timestamp;
+    if (!optionBook.prices(chain, prices, spot, timestamp)) return;
+    vols.resize(prices.size());
+    ImpliedVolBatch batch{optionBook.strikes(chain), optionBook.expiries(chain), optionBook.callFlags(chain), prices.data(), vols.data(), prices.size()};
+    auto start = std::chrono::steady_clock::now();
+    impliedVolKernel()(batch, spot, optionBook.riskFreeRate(), static_cast<double>(timestamp) / nanosPerYear);
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    const double *strikes = optionBook.strikes(chain), *expiries = optionBook.expiries(chain), *calls = optionBook.callFlags(chain);
+    std::size_t atTheMoney = static_cast<std::size_t>(watched);
+    for (std::size_t i = 0; i < vols.size(); ++i) {
+        if (expiries[i] == expiries[watched] && calls[i] != 0.0 &&
+            std::abs(strikes[i] - spot) < std::abs(strikes[atTheMoney] - spot)) atTheMoney = i;
+    }
+    line.assign("Stock: ").append(stock).append(" 30 day at the money implied vol ");
+    appendDouble(line, vols[atTheMoney], 6);
+    line.append(" (");
+    appendInteger(line, std::count_if(vols.begin(), vols.end(), [](double vol) { return !std::isnan(vol); }));
+    line.append(" of ");
+    appendInteger(line, vols.size());
+    line.append(" contracts solved in ");
+    appendInteger(line, micros);
+    line.append(" us)");
+    std::cout << line << std::endl;
 }
 
 // Use lock free accessor for low latency and high throughput
 void queryStockPrice(const std::string &stock) {
-    tbb::concurrent_hash_map<std::string, StockData>::const_accessor accessor;
-    while (true) {
+    StockPriceMap::const_accessor accessor;
+    std::string line;
+    while (running.load(std::memory_order_relaxed)) {
         auto start_time = std::chrono::high_resolution_clock::now(); // Start timer
         // Lock free access/lookup
         if (stockPrices.find(accessor, stock)) {
-            std::cout << "Stock: " << stock
-                      << " Price: $" << accessor->second.price.load(std::memory_order_relaxed)
-                      << std::endl;
+            line.assign("Stock: ").append(stock).append(" Price: $");
+            appendDouble(line, accessor->second.price.load(std::memory_order_relaxed), 6);
+            std::cout << line << std::endl;
+            PriceTick previous;
+            if (accessor->second.history.priceAsOf(wallClockNanos() - 1000000000, previous)) {
+                line.assign("Stock: ").append(stock).append(" Price 1s ago: $");
+                appendDouble(line, previous.price, 6);
+                std::cout << line << std::endl;
+            }
+            SymbolId id = accessor->second.id;
+            OptionQuote option;
+            if (id < watchedOption.size() && watchedOption[id] >= 0 &&
+                optionBook.quote(optionBook.chainIndex(id), watchedOption[id], option)) {
+                line.assign("Stock: ").append(stock).append(" 30 day call: $");
+                appendDouble(line, option.price, 6);
+                line.append(" delta ");
+                appendDouble(line, option.delta, 4);
+                line.append(" gamma ");
+                appendDouble(line, option.gamma, 4);
+                line.append(" vega ");
+                appendDouble(line, option.vega, 4);
+                std::cout << line << std::endl;
+                solveVolSurface(stock, id, watchedOption[id], line);
+            }
         } else {
             std::cout << "Stock not found: " << stock << std::endl;
         }
+        accessor.release(); // Don't hold the read lock while sleeping, it blocks the updater
         auto end_time = std::chrono::high_resolution_clock::now(); // End timer
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
         std::cout << "Query latency for " << stock << ": " << duration << " microseconds" << std::endl;
@@ -87,38 +567,261 @@ void queryStockPrice(const std::string &stock) {
     }
 }
 
-int main() {
+// Risk thread: folds each interval's returns into the basket's covariance, the rank-1 update runs
+// on every core, and prints the equal weighted basket's volatility per bar
+void runRisk(RiskStrategy::ReturnRing &returns, std::vector<SymbolId> basket) {
+    EwCovariance covariance(basket.size(), riskLambda);
+    std::vector<double> row, weights(basket.size(), 1.0 / basket.size());
+    std::string line;
+    while (running.load(std::memory_order_relaxed)) {
+        if (!returns.tryPop(row)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+        auto start = std::chrono::steady_clock::now();
+        covariance.update(row.data());
+        double volatility = std::sqrt(covariance.portfolioVariance(weights.data()));
+        auto micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        line.assign("Risk basket of ");
+        appendInteger(line, basket.size());
+        line.append(" bar volatility ");
+        appendDouble(line, volatility, 6);
+        if (basket.size() >= 2) {
+            line.append(" correlation ").append(symbols.name(basket[0])).append("/").append(symbols.name(basket[1])).append(" ");
+            appendDouble(line, covariance.correlation(0, 1), 3);
+        }
+        line.append(" update ");
+        appendInteger(line, micros);
+        line.append(" us");
+        std::cout << line << std::endl;
+    }
+}
+
+// What the query server answers from, called on its thread
+struct QueryHooks {
+    static SymbolId find(const std::string &name) { return symbols.find(name); }
+    static std::size_t symbolCount() { return stockSlots.size(); }
+    static uint64_t lastSeq(SymbolId id) { return stockSlots[id]->history.lastSeq(); }
+    static bool latest(SymbolId id, PriceTick &out) { return stockSlots[id]->history.lastTicks(1, &out) == 1; }
+    static const std::string &name(SymbolId id) { return symbols.name(id); }
+    static bool movers(MoversSnapshot &out) { return ::movers.snapshot(out); }
+};
+
+// Deterministic replay of a tick store, see --replay
+void replayTicks(TickStoreReader &reader, const std::vector<std::string> &names) {
+    constexpr int64_t batchInterval = 50000000; // Same cadence as the live batch updates
+    std::vector<StockData *> slots;
+    for (const auto &name : names) slots.push_back(stockSlots[symbols.find(name)]);
+
+    TickReplay replay(reader, names, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max());
+    auto start = std::chrono::steady_clock::now();
+    uint64_t ticks = replay.run(batchInterval,
+        [&slots](std::size_t stream, const Tick &tick) { applyPriceUpdate(*slots[stream], tick.price, tick.timestamp); },
+        [](int64_t now) { endBatch(now); });
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string line;
+    for (std::size_t i = 0; i < names.size(); ++i) {
+        line.assign("Replay close ").append(names[i]).append(" ");
+        appendDouble(line, slots[i]->price.load(std::memory_order_relaxed)); // Shortest text that reads back exactly
+        std::cout << line << std::endl;
+    }
+    // Timing is the only output that depends on the machine, keep it off stdout
+    std::cerr << "Replayed " << ticks << " ticks of " << names.size() << " symbols in "
+              << seconds << " s (" << ticks / seconds / 1e6 << "M ticks/s)" << std::endl;
+}
+
+int main(int argc, char **argv) {
     // Limit maximum number of threads that can run in parallel to the number of hardware threads available
     tbb::global_control globalLimit(tbb::global_control::max_allowed_parallelism, std::thread::hardware_concurrency());
 
+    std::cout << "Kernel dispatch level: " << cpuLevelName(cpuLevel()) << std::endl;
+
     {
-        tbb::concurrent_hash_map<std::string, StockData>::accessor accessor;
-        stockPrices.insert(accessor, "AAPL");
-        accessor->second = StockData(150.0);
+        const std::pair<const char *, double> listings[] = {
+            {"AAPL", 150.0}, {"GOOGL", 2800.0}, {"AMZN", 3400.0}, {"MSFT", 299.0}, {"TSLA", 720.0},
+        };
+        for (const auto &listing : listings) listSymbol(listing.first, listing.second);
+    }
 
-        stockPrices.insert(accessor, "GOOGL");
-        accessor->second = StockData(2800.0);
+    // --replay DIR runs the ticks recorded under DIR through the same apply and strategy code on
+    // this thread only, in recorded time, then exits; identical stores give identical output
+    std::string replayDirectory;
+    std::unique_ptr<TickStoreReader> replayReader;
+    std::vector<std::string> replaySymbols;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--replay") replayDirectory = argv[i + 1];
+    }
+    if (!replayDirectory.empty()) {
+        replayReader = std::make_unique<TickStoreReader>(replayDirectory);
+        replaySymbols = replayReader->symbols();
+        for (const auto &name : replaySymbols) listSymbol(name, 0.0);
+    }
 
-        stockPrices.insert(accessor, "AMZN");
-        accessor->second = StockData(3400.0);
+    // --record DIR keeps every update in the columnar tick store under DIR
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--record") recorder = std::make_unique<TickStoreWriter>(argv[i + 1]);
+    }
 
-        stockPrices.insert(accessor, "MSFT");
-        accessor->second = StockData(299.0);
+    // --broadcast NAME publishes every update to the shared memory ring NAME (e.g. /lowlatency-ticks)
+    // for tick_reader processes to follow
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) != "--broadcast") continue;
+        broadcaster = std::make_unique<TickBroadcastWriter>(argv[i + 1]);
+        for (SymbolId id = 0; id < symbols.size(); ++id) broadcaster->setSymbol(id, symbols.name(id));
+    }
 
-        stockPrices.insert(accessor, "TSLA");
-        accessor->second = StockData(720.0);
+    marketFeeds = std::make_unique<MarketFeeds>(symbols);
+    consolidatedQuotes = std::make_unique<QuoteConsolidator>(symbols.size());
+
+    // --gateway ADDRESS trades a toy strategy against the matching engine at ADDRESS (see exchange.cpp),
+    // its market data then drives the prices instead of the random batch updates
+    std::string gatewayAddress;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--gateway") gatewayAddress = argv[i + 1];
+    }
+    if (!gatewayAddress.empty() && replayReader) {
+        std::cerr << "--gateway can't be used with --replay, a replay never trades" << std::endl;
+        return 1;
+    }
+    RiskEngine risk(1, static_cast<uint32_t>(symbols.size()));
+    std::unique_ptr<OrderGateway<GatewayHooks>> gateway;
+    std::thread gatewayThread;
+    if (!gatewayAddress.empty()) {
+        gateway = std::make_unique<OrderGateway<GatewayHooks>>(gatewayAddress, risk);
+        strategies.get<FollowTickStrategy>().orders = &gateway->addStrategy();
+        strategies.subscribe<FollowTickStrategy>(symbols.find("AAPL"));
     }
+    strategies.subscribe<BarPrinterStrategy>(symbols.find("AAPL"));
+
+    // --strategy LIBRARY runs a strategy plugin (see strategy_abi.h) on every symbol, SIGHUP reloads it
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) != "--strategy") continue;
+        PluginStrategy &plugin = strategies.get<PluginStrategy>();
+        if (gateway) pluginOrders = &gateway->addStrategy();
+        plugin.setHost(StrategyHost{nullptr, sendPluginOrder, logPluginMessage});
+        try {
+            plugin.load(argv[i + 1]);
+        } catch (const std::exception &e) {
+            std::cerr << "Cannot load --strategy " << argv[i + 1] << ": " << e.what() << std::endl;
+            return 1;
+        }
+        for (SymbolId id = 0; id < symbols.size(); ++id) strategies.subscribe<PluginStrategy>(id);
+        std::signal(SIGHUP, handleReloadSignal);
+    }
+    // --alert AAPL>120 prints a line the first time AAPL trades at or above 120 (< for at or below),
+    // --stop AAPL>120:100 sends a buy order for 100 then (a sell order for <) through the gateway
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg != "--alert" && arg != "--stop") continue;
+        if (!addTrigger(argv[i + 1], arg == "--stop")) {
+            std::cerr << "Bad " << arg << " " << argv[i + 1] << std::endl;
+            return 1;
+        }
+        if (arg == "--stop" && gateway && !stopOrders) stopOrders = &gateway->addStrategy();
+    }
+
+    // --risk AAPL,MSFT,... (or all) keeps the covariance of the basket's bar returns on a risk thread,
+    // live runs only
+    std::vector<SymbolId> riskBasket;
+    RiskStrategy::ReturnRing riskReturns;
+    for (int i = 1; i + 1 < argc && !replayReader; ++i) {
+        if (std::string(argv[i]) != "--risk") continue;
+        std::string list = argv[i + 1];
+        std::vector<std::string_view> names;
+        CsvCursor(list.data(), list.data() + list.size()).next(names);
+        for (SymbolId id = 0; id < symbols.size(); ++id) {
+            if (list == "all" || std::find(names.begin(), names.end(), symbols.name(id)) != names.end()) riskBasket.push_back(id);
+        }
+    }
+    if (!riskBasket.empty()) {
+        RiskStrategy &risk = strategies.get<RiskStrategy>();
+        risk.returns = &riskReturns;
+        risk.member.assign(symbols.size(), -1);
+        risk.closes.assign(riskBasket.size(), 0.0);
+        for (std::size_t i = 0; i < riskBasket.size(); ++i) {
+            risk.member[riskBasket[i]] = static_cast<int32_t>(i);
+            strategies.subscribe<RiskStrategy>(riskBasket[i]);
+        }
+    }
+
+    // --options AAPL,MSFT,... lists a made up chain of about 1000 contracts on each, repriced on
+    // every tick of the underlying
+    watchedOption.assign(symbols.size(), -1);
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) != "--options") continue;
+        std::string list = argv[i + 1];
+        std::vector<std::string_view> names;
+        CsvCursor(list.data(), list.data() + list.size()).next(names);
+        for (std::string_view name : names) {
+            SymbolId id = symbols.find(std::string(name));
+            if (id == invalidSymbol || optionBook.chainIndex(id) >= 0) continue;
+            double spot = stockSlots[id]->price.load(std::memory_order_relaxed);
+            watchedOption[id] = static_cast<long>(listSyntheticChain(id, spot > 0.0 ? spot : 100.0, wallClockNanos()));
+        }
+    }
+
+    if (gateway) gatewayThread = std::thread([&gateway] { gateway->run(running); });
+
+    if (replayReader) {
+        replayTicks(*replayReader, replaySymbols);
+        return 0;
+    }
+
+    std::signal(SIGINT, handleSignal);
+
+    // --serve ADDRESS (repeatable, host:port or a Unix socket path) answers price queries from other
+    // processes over the binary protocol in query_wire.h, see query_client.cpp
+    // --query-backend uring serves them through io_uring instead of epoll
+    std::vector<std::string> queryAddresses;
+    bool uringQueries = false;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--serve") queryAddresses.push_back(argv[i + 1]);
+        if (std::string(argv[i]) == "--query-backend") uringQueries = std::string(argv[i + 1]) == "uring";
+    }
+    std::unique_ptr<QueryServer<QueryHooks>> queryServer;
+    std::unique_ptr<UringQueryServer<QueryHooks>> uringQueryServer;
+    std::thread queryServerThread;
+    if (!queryAddresses.empty() && uringQueries) {
+        uringQueryServer = std::make_unique<UringQueryServer<QueryHooks>>(queryAddresses);
+        queryServerThread = std::thread([&uringQueryServer] { uringQueryServer->run(running); });
+    } else if (!queryAddresses.empty()) {
+        queryServer = std::make_unique<QueryServer<QueryHooks>>(queryAddresses);
+        queryServerThread = std::thread([&queryServer] { queryServer->run(running); });
+    }
+
+    // --websocket ADDRESS (repeatable) serves the same prices as JSON over WebSocket for dashboards,
+    // see websocket_protocol.h
+    std::vector<std::string> webSocketAddresses;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--websocket") webSocketAddresses.push_back(argv[i + 1]);
+    }
+    std::unique_ptr<QueryServer<QueryHooks, WebSocketProtocol<QueryHooks>>> webSocketServer;
+    std::thread webSocketThread;
+    if (!webSocketAddresses.empty()) {
+        webSocketServer = std::make_unique<QueryServer<QueryHooks, WebSocketProtocol<QueryHooks>>>(webSocketAddresses);
+        webSocketThread = std::thread([&webSocketServer] { webSocketServer->run(running); });
+    }
+
+    std::thread riskThread;
+    if (!riskBasket.empty()) riskThread = std::thread(runRisk, std::ref(riskReturns), riskBasket);
 
-    std::thread updateThread(simulateBatchUpdates);
+    std::thread updateThread;
+    if (!gateway) updateThread = std::thread(simulateBatchUpdates);
 
     std::thread queryThread1(queryStockPrice, "AAPL");
     std::thread queryThread2(queryStockPrice, "GOOGL");
     std::thread queryThread3(queryStockPrice, "MSFT");
 
-    updateThread.join();
+    if (updateThread.joinable()) updateThread.join();
     queryThread1.join();
     queryThread2.join();
     queryThread3.join();
+    if (gatewayThread.joinable()) gatewayThread.join();
+    if (queryServerThread.joinable()) queryServerThread.join();
+    if (webSocketThread.joinable()) webSocketThread.join();
+    if (riskThread.joinable()) riskThread.join();
+    if (recorder) recorder->flush();
 
     return 0;
 }
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read only memory mapping of a whole file, shared with the page cache
+// An empty file maps to a null pointer with size 0
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string &path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        length = static_cast<std::size_t>(st.st_size);
+        if (length > 0) {
+            void *p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot mmap " + path);
+            }
+            bytes = static_cast<const uint8_t *>(p);
+        }
+        ::close(fd); // The mapping keeps the file alive
+    }
+
+    MappedFile(MappedFile &&other) noexcept
+        : bytes(std::exchange(other.bytes, nullptr)), length(std::exchange(other.length, 0)) {}
+
+    MappedFile& operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            unmap();
+            bytes = std::exchange(other.bytes, nullptr);
+            length = std::exchange(other.length, 0);
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() { unmap(); }
+
+    // Hint the kernel that the mapping will be read front to back
+    void adviseSequential() const {
+        if (bytes) ::madvise(const_cast<uint8_t *>(bytes), length, MADV_SEQUENTIAL);
+    }
+
+    const uint8_t *data() const { return bytes; }
+    std::size_t size() const { return length; }
+
+private:
+    void unmap() {
+        if (bytes) ::munmap(const_cast<uint8_t *>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+    }
+
+    const uint8_t *bytes = nullptr;
+    std::size_t length = 0;
+};
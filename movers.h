@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "double_buffer.h"
+#include "symbols.h"
+
+// Live leaderboards over every priced symbol: top gainers and losers against the symbol's first
+// price, and the most active by number of updates
+// Each board is an indexed heap over all symbols, so an update moves one symbol in O(log n) per
+// board and nothing is ever sorted; publish() takes the top N off each heap in O(N log N) without
+// changing it and writes them into the back one of two snapshot buffers (double_buffer.h)
+// Single writer (the thread applying prices); readers copy the front buffer from any thread
+
+enum MoversBoard : uint8_t {
+    TopGainers,
+    TopLosers,
+    MostActive,
+    moversBoardCount,
+};
+
+constexpr std::size_t moversCapacity = 64; // Most entries a board can publish
+
+struct Mover {
+    SymbolId symbol;
+    double price;
+    double change;  // Against the first price, 0.05 is +5%
+    uint64_t ticks; // Updates so far
+};
+
+struct MoversSnapshot {
+    uint64_t version = 0; // Publishes so far, 0 before the first
+    uint32_t counts[moversBoardCount] = {};
+    Mover boards[moversBoardCount][moversCapacity];
+};
+
+// Max heap of symbol ids on a key per symbol, with each symbol's position for O(log n) updates
+class IndexedHeap {
+public:
+    void set(SymbolId symbol, double key) {
+        if (symbol >= positions.size()) {
+            positions.resize(symbol + 1, notInHeap);
+            keys.resize(symbol + 1);
+        }
+        double old = keys[symbol];
+        keys[symbol] = key;
+        if (positions[symbol] == notInHeap) {
+            positions[symbol] = static_cast<uint32_t>(heap.size());
+            heap.push_back(symbol);
+            siftUp(positions[symbol]);
+        } else if (key > old) {
+            siftUp(positions[symbol]);
+        } else if (key < old) {
+            siftDown(positions[symbol]);
+        }
+    }
+
+    // The n highest keys, highest first, the heap is left as it is
+    template <typename Fn>
+    void top(std::size_t n, Fn &&fn) {
+        if (heap.empty() || n == 0) return;
+        // Best first walk: the next highest is always a child of one already taken
+        frontier.assign(1, 0);
+        auto lower = [this](uint32_t a, uint32_t b) { return keys[heap[a]] < keys[heap[b]]; };
+        while (n-- > 0 && !frontier.empty()) {
+            std::pop_heap(frontier.begin(), frontier.end(), lower);
+            uint32_t at = frontier.back();
+            frontier.pop_back();
+            fn(heap[at]);
+            for (uint32_t child = 2 * at + 1; child <= 2 * at + 2 && child < heap.size(); ++child) {
+                frontier.push_back(child);
+                std::push_heap(frontier.begin(), frontier.end(), lower);
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t notInHeap = ~uint32_t(0);
+
+    void place(uint32_t at, SymbolId symbol) {
+        heap[at] = symbol;
+        positions[symbol] = at;
+    }
+
+    void siftUp(uint32_t at) {
+        SymbolId symbol = heap[at];
+        while (at > 0) {
+            uint32_t parent = (at - 1) / 2;
+            if (keys[heap[parent]] >= keys[symbol]) break;
+            place(at, heap[parent]);
+            at = parent;
+        }
+        place(at, symbol);
+    }
+
+    void siftDown(uint32_t at) {
+        SymbolId symbol = heap[at];
+        uint32_t size = static_cast<uint32_t>(heap.size());
+        while (true) {
+            uint32_t child = 2 * at + 1;
+            if (child >= size) break;
+            if (child + 1 < size && keys[heap[child + 1]] > keys[heap[child]]) ++child;
+            if (keys[heap[child]] <= keys[symbol]) break;
+            place(at, heap[child]);
+            at = child;
+        }
+        place(at, symbol);
+    }
+
+    std::vector<SymbolId> heap;
+    std::vector<uint32_t> positions; // By symbol id
+    std::vector<double> keys;        // By symbol id
+    std::vector<uint32_t> frontier;  // Scratch of top()
+};
+
+class MoversTracker {
+public:
+    explicit MoversTracker(std::size_t topN) : topN(std::min(topN, moversCapacity)) {}
+
+    MoversTracker(const MoversTracker &) = delete;
+    MoversTracker &operator=(const MoversTracker &) = delete;
+
+    // Writer side, on every applied price
+    void onPrice(SymbolId symbol, double price) {
+        if (symbol >= symbols.size()) symbols.resize(symbol + 1);
+        SymbolState &state = symbols[symbol];
+        if (state.ticks++ == 0) state.reference = price;
+        state.price = price;
+        double change = state.reference != 0.0 ? price / state.reference - 1.0 : 0.0;
+        heaps[TopGainers].set(symbol, change);
+        heaps[TopLosers].set(symbol, -change);
+        heaps[MostActive].set(symbol, static_cast<double>(state.ticks));
+        changed = true;
+    }
+
+    // Writer side, makes the boards as of now visible to readers; returns false when nothing
+    // changed since the last publish or a reader still holds the back buffer (then the next
+    // publish catches up)
+    bool publish() {
+        if (!changed) return false;
+        bool published = snapshots.publish([this](MoversSnapshot &snapshot) {
+            snapshot.version = ++publishCount;
+            for (unsigned board = 0; board < moversBoardCount; ++board) {
+                uint32_t count = 0;
+                heaps[board].top(topN, [&](SymbolId symbol) {
+                    const SymbolState &state = symbols[symbol];
+                    double change = state.reference != 0.0 ? state.price / state.reference - 1.0 : 0.0;
+                    snapshot.boards[board][count++] = Mover{symbol, state.price, change, state.ticks};
+                });
+                snapshot.counts[board] = count;
+            }
+        });
+        if (published) changed = false;
+        return published;
+    }
+
+    // Reader side, any thread: copies the last published boards, false before the first publish
+    bool snapshot(MoversSnapshot &out) const {
+        return snapshots.read([&out](const MoversSnapshot &snapshot) {
+            out = snapshot;
+            return out.version != 0;
+        });
+    }
+
+private:
+    struct SymbolState {
+        double reference = 0.0; // First price
+        double price = 0.0;
+        uint64_t ticks = 0;
+    };
+
+    std::size_t topN;
+    IndexedHeap heaps[moversBoardCount];
+    std::vector<SymbolState> symbols; // By symbol id
+    bool changed = false;
+    uint64_t publishCount = 0;
+    DoubleBuffer<MoversSnapshot> snapshots;
+};
@@ -0,0 +1,424 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <immintrin.h>
+
+#include "cpu_dispatch.h"
+#include "double_buffer.h"
+#include "symbols.h"
+
+// Black-Scholes pricing and greeks of option chains, repriced on every underlying tick
+// A chain keeps its contracts as columns (strike, expiry, volatility, call flag) and the kernel
+// prices a whole chain at once: AVX-512 and AVX2 versions with their own exp, log and erfc, and a
+// scalar version with the same approximations, so every level gives the same numbers to rounding
+// exp and log are polynomial to about 1e-15; erfc is Numerical Recipes' erfcc, relative error below
+// 1.2e-7, which bounds the error of prices and greeks
+// No dividends; rate is continuously compounded; time is in years of 365 days
+
+constexpr double nanosPerYear = 365.0 * 86400.0 * 1e9;
+constexpr double minYearsToExpiry = 1e-9; // Expired contracts are priced just before expiry
+
+// Columns of one chain, n contracts
+struct BlackScholesBatch {
+    const double *strike;
+    const double *expiry;     // Years since the epoch
+    const double *volatility;
+    const double *call;       // 1 for a call, 0 for a put
+    double *price;
+    double *delta;
+    double *gamma;
+    double *vega;             // Per 1.00 of volatility
+    std::size_t n;
+};
+
+namespace bsconst {
+constexpr double log2e = 1.4426950408889634;
+constexpr double ln2Hi = 6.93147180369123816490e-01; // ln 2 split so n * ln2Hi is exact
+constexpr double ln2Lo = 1.90821492927058770002e-10;
+constexpr double ln2 = 0.6931471805599453;
+constexpr double sqrt2 = 1.4142135623730951;
+constexpr double invSqrt2 = 0.7071067811865476;
+constexpr double invSqrt2Pi = 0.3989422804014327;
+constexpr double expLimit = 708.0;
+// 1/k! for the exp Taylor polynomial, highest first
+constexpr double expCoefficients[] = {
+    1.0 / 39916800, 1.0 / 3628800, 1.0 / 362880, 1.0 / 40320, 1.0 / 5040, 1.0 / 720,
+    1.0 / 120, 1.0 / 24, 1.0 / 6, 1.0 / 2, 1.0, 1.0,
+};
+// 1/(2k+1) for 2 atanh(s), highest first
+constexpr double logCoefficients[] = {
+    1.0 / 19, 1.0 / 17, 1.0 / 15, 1.0 / 13, 1.0 / 11, 1.0 / 9, 1.0 / 7, 1.0 / 5, 1.0 / 3, 1.0,
+};
+// erfcc: erfc(z) = t exp(-z^2 + P(t)), t = 1 / (1 + z / 2), highest first
+constexpr double erfcCoefficients[] = {
+    0.17087277, -0.82215223, 1.48851587, -1.13520398, 0.27886807,
+    -0.18628806, 0.09678418, 0.37409196, 1.00002368, -1.26551223,
+};
+} // namespace bsconst
+
+// Scalar versions of the approximations, also the reference for the vector ones
+
+inline double expApprox(double x) {
+    using namespace bsconst;
+    x = std::min(std::max(x, -expLimit), expLimit);
+    double n = std::nearbyint(x * log2e);
+    double r = x - n * ln2Hi - n * ln2Lo;
+    double p = expCoefficients[0];
+    for (std::size_t k = 1; k < sizeof(expCoefficients) / sizeof(double); ++k) p = p * r + expCoefficients[k];
+    return std::ldexp(p, static_cast<int>(n));
+}
+
+// x > 0
+inline double logApprox(double x) {
+    using namespace bsconst;
+    int exponent;
+    double m = 2.0 * std::frexp(x, &exponent); // [1, 2)
+    double e = exponent - 1;
+    if (m > sqrt2) {
+        m *= 0.5;
+        e += 1.0;
+    }
+    double s = (m - 1.0) / (m + 1.0), s2 = s * s;
+    double p = logCoefficients[0];
+    for (std::size_t k = 1; k < sizeof(logCoefficients) / sizeof(double); ++k) p = p * s2 + logCoefficients[k];
+    return e * ln2 + 2.0 * s * p;
+}
+
+// Standard normal distribution function
+inline double normalCdfApprox(double x) {
+    using namespace bsconst;
+    double z = std::abs(x) * invSqrt2;
+    double t = 1.0 / (1.0 + 0.5 * z);
+    double p = erfcCoefficients[0];
+    for (std::size_t k = 1; k < sizeof(erfcCoefficients) / sizeof(double); ++k) p = p * t + erfcCoefficients[k];
+    double half = 0.5 * t * expApprox(p - z * z);
+    return x >= 0.0 ? 1.0 - half : half;
+}
+
+inline void blackScholesScalar(const BlackScholesBatch &batch, double spot, double rate, double now) {
+    using namespace bsconst;
+    for (std::size_t i = 0; i < batch.n; ++i) {
+        double years = std::max(batch.expiry[i] - now, minYearsToExpiry);
+        double rootYears = std::sqrt(years);
+        double vol = batch.volatility[i];
+        double volRoot = vol * rootYears;
+        double d1 = (logApprox(spot / batch.strike[i]) + (rate + 0.5 * vol * vol) * years) / volRoot;
+        double d2 = d1 - volRoot;
+        double discounted = batch.strike[i] * expApprox(-rate * years);
+        double nd1 = normalCdfApprox(d1), nd2 = normalCdfApprox(d2);
+        double callPrice = spot * nd1 - discounted * nd2;
+        double put = 1.0 - batch.call[i];
+        double density = expApprox(-0.5 * d1 * d1) * invSqrt2Pi;
+        batch.price[i] = callPrice + put * (discounted - spot);
+        batch.delta[i] = nd1 - put;
+        batch.gamma[i] = density / (spot * volRoot);
+        batch.vega[i] = spot * density * rootYears;
+    }
+}
+
+// AVX2, multiply and add rather than FMA since the level doesn't promise FMA
+// Conversions between int64 and double go through the 2^52 + 2^51 bias, exact for |v| < 2^51
+
+__attribute__((target("avx2")))
+inline __m256d polynomialAvx2(__m256d x, const double *coefficients, std::size_t count) {
+    __m256d p = _mm256_set1_pd(coefficients[0]);
+    for (std::size_t k = 1; k < count; ++k) p = _mm256_add_pd(_mm256_mul_pd(p, x), _mm256_set1_pd(coefficients[k]));
+    return p;
+}
+
+__attribute__((target("avx2")))
+inline __m256d expAvx2(__m256d x) {
+    using namespace bsconst;
+    const __m256d bias = _mm256_set1_pd(6755399441055744.0);
+    x = _mm256_max_pd(_mm256_min_pd(x, _mm256_set1_pd(expLimit)), _mm256_set1_pd(-expLimit));
+    __m256d n = _mm256_round_pd(_mm256_mul_pd(x, _mm256_set1_pd(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(n, _mm256_set1_pd(ln2Hi))), _mm256_mul_pd(n, _mm256_set1_pd(ln2Lo)));
+    __m256d p = polynomialAvx2(r, expCoefficients, sizeof(expCoefficients) / sizeof(double));
+    __m256i integer = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(n, bias)), _mm256_castpd_si256(bias));
+    __m256i scale = _mm256_slli_epi64(_mm256_add_epi64(integer, _mm256_set1_epi64x(1023)), 52);
+    return _mm256_mul_pd(p, _mm256_castsi256_pd(scale));
+}
+
+__attribute__((target("avx2")))
+inline __m256d logAvx2(__m256d x) {
+    using namespace bsconst;
+    const __m256d bias = _mm256_set1_pd(6755399441055744.0);
+    const __m256d one = _mm256_set1_pd(1.0);
+    __m256i bits = _mm256_castpd_si256(x);
+    __m256i exponent = _mm256_sub_epi64(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(1023));
+    __m256d e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_add_epi64(exponent, _mm256_castpd_si256(bias))), bias);
+    __m256i mantissa = _mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFFll));
+    __m256d m = _mm256_castsi256_pd(_mm256_or_si256(mantissa, _mm256_castpd_si256(one))); // [1, 2)
+    __m256d high = _mm256_cmp_pd(m, _mm256_set1_pd(sqrt2), _CMP_GT_OQ);
+    m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), high);
+    e = _mm256_add_pd(e, _mm256_and_pd(high, one));
+    __m256d s = _mm256_div_pd(_mm256_sub_pd(m, one), _mm256_add_pd(m, one));
+    __m256d p = polynomialAvx2(_mm256_mul_pd(s, s), logCoefficients, sizeof(logCoefficients) / sizeof(double));
+    return _mm256_add_pd(_mm256_mul_pd(e, _mm256_set1_pd(ln2)), _mm256_mul_pd(_mm256_add_pd(s, s), p));
+}
+
+__attribute__((target("avx2")))
+inline __m256d normalCdfAvx2(__m256d x) {
+    using namespace bsconst;
+    const __m256d one = _mm256_set1_pd(1.0), half = _mm256_set1_pd(0.5);
+    __m256d z = _mm256_mul_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.0), x), _mm256_set1_pd(invSqrt2));
+    __m256d t = _mm256_div_pd(one, _mm256_add_pd(one, _mm256_mul_pd(half, z)));
+    __m256d p = polynomialAvx2(t, erfcCoefficients, sizeof(erfcCoefficients) / sizeof(double));
+    __m256d tail = _mm256_mul_pd(_mm256_mul_pd(half, t), expAvx2(_mm256_sub_pd(p, _mm256_mul_pd(z, z))));
+    return _mm256_blendv_pd(_mm256_sub_pd(one, tail), tail, _mm256_cmp_pd(x, _mm256_setzero_pd(), _CMP_LT_OQ));
+}
+
+__attribute__((target("avx2")))
+inline void blackScholesAvx2(const BlackScholesBatch &batch, double spot, double rate, double now) {
+    using namespace bsconst;
+    const __m256d spotVec = _mm256_set1_pd(spot), rateVec = _mm256_set1_pd(rate), nowVec = _mm256_set1_pd(now);
+    const __m256d half = _mm256_set1_pd(0.5), one = _mm256_set1_pd(1.0);
+    std::size_t i = 0;
+    for (; i + 4 <= batch.n; i += 4) {
+        __m256d years = _mm256_max_pd(_mm256_sub_pd(_mm256_loadu_pd(batch.expiry + i), nowVec), _mm256_set1_pd(minYearsToExpiry));
+        __m256d rootYears = _mm256_sqrt_pd(years);
+        __m256d vol = _mm256_loadu_pd(batch.volatility + i);
+        __m256d volRoot = _mm256_mul_pd(vol, rootYears);
+        __m256d strike = _mm256_loadu_pd(batch.strike + i);
+        __m256d drift = _mm256_mul_pd(_mm256_add_pd(rateVec, _mm256_mul_pd(half, _mm256_mul_pd(vol, vol))), years);
+        __m256d d1 = _mm256_div_pd(_mm256_add_pd(logAvx2(_mm256_div_pd(spotVec, strike)), drift), volRoot);
+        __m256d d2 = _mm256_sub_pd(d1, volRoot);
+        __m256d discounted = _mm256_mul_pd(strike, expAvx2(_mm256_sub_pd(_mm256_setzero_pd(), _mm256_mul_pd(rateVec, years))));
+        __m256d nd1 = normalCdfAvx2(d1), nd2 = normalCdfAvx2(d2);
+        __m256d callPrice = _mm256_sub_pd(_mm256_mul_pd(spotVec, nd1), _mm256_mul_pd(discounted, nd2));
+        __m256d put = _mm256_sub_pd(one, _mm256_loadu_pd(batch.call + i));
+        __m256d density = _mm256_mul_pd(expAvx2(_mm256_mul_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(d1, d1))), _mm256_set1_pd(invSqrt2Pi));
+        _mm256_storeu_pd(batch.price + i, _mm256_add_pd(callPrice, _mm256_mul_pd(put, _mm256_sub_pd(discounted, spotVec))));
+        _mm256_storeu_pd(batch.delta + i, _mm256_sub_pd(nd1, put));
+        _mm256_storeu_pd(batch.gamma + i, _mm256_div_pd(density, _mm256_mul_pd(spotVec, volRoot)));
+        _mm256_storeu_pd(batch.vega + i, _mm256_mul_pd(_mm256_mul_pd(spotVec, density), rootYears));
+    }
+    BlackScholesBatch tail = batch;
+    tail.strike += i, tail.expiry += i, tail.volatility += i, tail.call += i;
+    tail.price += i, tail.delta += i, tail.gamma += i, tail.vega += i;
+    tail.n -= i;
+    blackScholesScalar(tail, spot, rate, now);
+}
+
+// AVX-512: FMA, scalef for 2^n and getexp/getmant for the log's split
+// GCC 12 flags the deliberately undefined source operand inside its own AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+// 1 / x from the 14 bit estimate and two Newton steps, about as exact as a divide at a fraction
+// of its cost
+__attribute__((target("avx512f")))
+inline __m512d reciprocalAvx512(__m512d x) {
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512d r = _mm512_rcp14_pd(x);
+    r = _mm512_fmadd_pd(r, _mm512_fnmadd_pd(x, r, one), r);
+    return _mm512_fmadd_pd(r, _mm512_fnmadd_pd(x, r, one), r);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d polynomialAvx512(__m512d x, const double *coefficients, std::size_t count) {
+    __m512d p = _mm512_set1_pd(coefficients[0]);
+    for (std::size_t k = 1; k < count; ++k) p = _mm512_fmadd_pd(p, x, _mm512_set1_pd(coefficients[k]));
+    return p;
+}
+
+__attribute__((target("avx512f")))
+inline __m512d expAvx512(__m512d x) {
+    using namespace bsconst;
+    x = _mm512_max_pd(_mm512_min_pd(x, _mm512_set1_pd(expLimit)), _mm512_set1_pd(-expLimit));
+    __m512d n = _mm512_roundscale_pd(_mm512_mul_pd(x, _mm512_set1_pd(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m512d r = _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2Lo), _mm512_fnmadd_pd(n, _mm512_set1_pd(ln2Hi), x));
+    return _mm512_scalef_pd(polynomialAvx512(r, expCoefficients, sizeof(expCoefficients) / sizeof(double)), n);
+}
+
+__attribute__((target("avx512f")))
+inline __m512d logAvx512(__m512d x) {
+    using namespace bsconst;
+    const __m512d one = _mm512_set1_pd(1.0);
+    __m512d e = _mm512_getexp_pd(x);
+    __m512d m = _mm512_getmant_pd(x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero); // [1, 2)
+    __mmask8 high = _mm512_cmp_pd_mask(m, _mm512_set1_pd(sqrt2), _CMP_GT_OQ);
+    m = _mm512_mask_mul_pd(m, high, m, _mm512_set1_pd(0.5));
+    e = _mm512_mask_add_pd(e, high, e, one);
+    __m512d s = _mm512_mul_pd(_mm512_sub_pd(m, one), reciprocalAvx512(_mm512_add_pd(m, one)));
+    __m512d p = polynomialAvx512(_mm512_mul_pd(s, s), logCoefficients, sizeof(logCoefficients) / sizeof(double));
+    return _mm512_fmadd_pd(e, _mm512_set1_pd(ln2), _mm512_mul_pd(_mm512_add_pd(s, s), p));
+}
+
+__attribute__((target("avx512f")))
+inline __m512d normalCdfAvx512(__m512d x) {
+    using namespace bsconst;
+    const __m512d one = _mm512_set1_pd(1.0), half = _mm512_set1_pd(0.5);
+    __m512d z = _mm512_mul_pd(_mm512_abs_pd(x), _mm512_set1_pd(invSqrt2));
+    __m512d t = reciprocalAvx512(_mm512_fmadd_pd(half, z, one));
+    __m512d p = polynomialAvx512(t, erfcCoefficients, sizeof(erfcCoefficients) / sizeof(double));
+    __m512d tail = _mm512_mul_pd(_mm512_mul_pd(half, t), expAvx512(_mm512_fnmadd_pd(z, z, p)));
+    __mmask8 negative = _mm512_cmp_pd_mask(x, _mm512_setzero_pd(), _CMP_LT_OQ);
+    return _mm512_mask_blend_pd(negative, _mm512_sub_pd(one, tail), tail);
+}
+
+__attribute__((target("avx512f")))
+inline void blackScholesAvx512(const BlackScholesBatch &batch, double spot, double rate, double now) {
+    using namespace bsconst;
+    const __m512d spotVec = _mm512_set1_pd(spot), rateVec = _mm512_set1_pd(rate), nowVec = _mm512_set1_pd(now);
+    const __m512d half = _mm512_set1_pd(0.5), one = _mm512_set1_pd(1.0);
+    for (std::size_t i = 0; i < batch.n; i += 8) {
+        // The last group runs masked, lanes past n are priced as a 1 year at the money call
+        __mmask8 lanes = batch.n - i >= 8 ? 0xFF : static_cast<__mmask8>((1u << (batch.n - i)) - 1);
+        __m512d years = _mm512_max_pd(_mm512_sub_pd(_mm512_mask_loadu_pd(_mm512_add_pd(nowVec, one), lanes, batch.expiry + i), nowVec),
+                                      _mm512_set1_pd(minYearsToExpiry));
+        __m512d rootYears = _mm512_sqrt_pd(years);
+        __m512d vol = _mm512_mask_loadu_pd(half, lanes, batch.volatility + i);
+        __m512d volRoot = _mm512_mul_pd(vol, rootYears);
+        __m512d strike = _mm512_mask_loadu_pd(spotVec, lanes, batch.strike + i);
+        __m512d drift = _mm512_mul_pd(_mm512_fmadd_pd(half, _mm512_mul_pd(vol, vol), rateVec), years);
+        __m512d inverseVolRoot = reciprocalAvx512(volRoot);
+        __m512d d1 = _mm512_mul_pd(_mm512_add_pd(logAvx512(_mm512_mul_pd(spotVec, reciprocalAvx512(strike))), drift), inverseVolRoot);
+        __m512d d2 = _mm512_sub_pd(d1, volRoot);
+        __m512d discounted = _mm512_mul_pd(strike, expAvx512(_mm512_sub_pd(_mm512_setzero_pd(), _mm512_mul_pd(rateVec, years))));
+        __m512d nd1 = normalCdfAvx512(d1), nd2 = normalCdfAvx512(d2);
+        __m512d callPrice = _mm512_fnmadd_pd(discounted, nd2, _mm512_mul_pd(spotVec, nd1));
+        __m512d put = _mm512_sub_pd(one, _mm512_mask_loadu_pd(one, lanes, batch.call + i));
+        __m512d density = _mm512_mul_pd(expAvx512(_mm512_mul_pd(_mm512_set1_pd(-0.5), _mm512_mul_pd(d1, d1))), _mm512_set1_pd(invSqrt2Pi));
+        _mm512_mask_storeu_pd(batch.price + i, lanes, _mm512_fmadd_pd(put, _mm512_sub_pd(discounted, spotVec), callPrice));
+        _mm512_mask_storeu_pd(batch.delta + i, lanes, _mm512_sub_pd(nd1, put));
+        _mm512_mask_storeu_pd(batch.gamma + i, lanes, _mm512_mul_pd(_mm512_mul_pd(density, inverseVolRoot), _mm512_set1_pd(1.0 / spot)));
+        _mm512_mask_storeu_pd(batch.vega + i, lanes, _mm512_mul_pd(_mm512_mul_pd(spotVec, density), rootYears));
+    }
+}
+
+#pragma GCC diagnostic pop
+
+using BlackScholesKernel = void (*)(const BlackScholesBatch &, double, double, double);
+
+inline BlackScholesKernel blackScholesKernel() {
+    static const BlackScholesKernel kernel = selectKernel(blackScholesScalar, nullptr, blackScholesAvx2, blackScholesAvx512);
+    return kernel;
+}
+
+struct OptionContract {
+    double strike;
+    int64_t expiry; // Nanoseconds since the epoch
+    double volatility;
+    bool call;
+};
+
+// Latest price and greeks of one contract, with the underlying tick they came from
+struct OptionQuote {
+    double price;
+    double delta;
+    double gamma;
+    double vega;
+    double spot;
+    int64_t timestamp;
+};
+
+// Every listed chain, keyed by underlying symbol, repriced whole on each tick of its underlying
+// Single writer (the thread applying prices); results go into the back one of two buffers per
+// chain (double_buffer.h), readers copy from the front one from any thread; a tick's repricing
+// is skipped while a reader still holds the back buffer, the next tick catches up
+class OptionBook {
+public:
+    explicit OptionBook(double rate) : rate(rate) {}
+
+    OptionBook(const OptionBook &) = delete;
+    OptionBook &operator=(const OptionBook &) = delete;
+
+    // Before the writer starts; returns the chain's index
+    std::size_t list(SymbolId underlying, const std::vector<OptionContract> &contracts) {
+        if (underlying >= chainOf.size()) chainOf.resize(underlying + 1, noChain);
+        chainOf[underlying] = static_cast<uint32_t>(chains.size());
+        auto chain = std::make_unique<Chain>();
+        chain->underlying = underlying;
+        for (const OptionContract &contract : contracts) {
+            chain->strike.push_back(contract.strike);
+            chain->expiry.push_back(static_cast<double>(contract.expiry) / nanosPerYear);
+            chain->volatility.push_back(contract.volatility);
+            chain->call.push_back(contract.call ? 1.0 : 0.0);
+        }
+        chain->results.initialize([&contracts](Results &results) { results.resize(contracts.size()); });
+        chains.push_back(std::move(chain));
+        return chains.size() - 1;
+    }
+
+    // Writer side, on every applied price; false when the symbol has no chain or the repricing
+    // was skipped
+    bool onPrice(SymbolId underlying, double spot, int64_t timestamp) {
+        if (underlying >= chainOf.size() || chainOf[underlying] == noChain || !(spot > 0.0)) return false;
+        Chain &chain = *chains[chainOf[underlying]];
+        return chain.results.publish([&](Results &results) {
+            BlackScholesBatch batch{chain.strike.data(), chain.expiry.data(), chain.volatility.data(), chain.call.data(),
+                                    results.price.data(), results.delta.data(), results.gamma.data(), results.vega.data(),
+                                    chain.strike.size()};
+            kernel(batch, spot, rate, static_cast<double>(timestamp) / nanosPerYear);
+            results.spot = spot;
+            results.timestamp = timestamp;
+        });
+    }
+
+    // Reader side, any thread: false before the chain's first repricing
+    bool quote(std::size_t chainIndex, std::size_t contract, OptionQuote &out) const {
+        return chains[chainIndex]->results.read([&](const Results &results) {
+            out = OptionQuote{results.price[contract], results.delta[contract], results.gamma[contract],
+                              results.vega[contract], results.spot, results.timestamp};
+            return out.timestamp != 0;
+        });
+    }
+
+    // Reader side, any thread: the whole chain's prices and the tick they came from, false before
+    // the first repricing
+    bool prices(std::size_t chainIndex, std::vector<double> &out, double &spot, int64_t &timestamp) const {
+        return chains[chainIndex]->results.read([&](const Results &results) {
+            out = results.price;
+            spot = results.spot;
+            timestamp = results.timestamp;
+            return timestamp != 0;
+        });
+    }
+
+    // A chain's contract columns, fixed once it is listed
+    const double *strikes(std::size_t chainIndex) const { return chains[chainIndex]->strike.data(); }
+    const double *expiries(std::size_t chainIndex) const { return chains[chainIndex]->expiry.data(); }
+    const double *callFlags(std::size_t chainIndex) const { return chains[chainIndex]->call.data(); }
+    double riskFreeRate() const { return rate; }
+
+    // Chain index of an underlying, or -1
+    long chainIndex(SymbolId underlying) const {
+        return underlying < chainOf.size() && chainOf[underlying] != noChain ? static_cast<long>(chainOf[underlying]) : -1;
+    }
+
+    std::size_t contractCount(std::size_t chainIndex) const { return chains[chainIndex]->strike.size(); }
+
+private:
+    static constexpr uint32_t noChain = ~uint32_t(0);
+
+    struct Results {
+        std::vector<double> price, delta, gamma, vega;
+        double spot = 0.0;
+        int64_t timestamp = 0;
+
+        void resize(std::size_t n) {
+            price.resize(n);
+            delta.resize(n);
+            gamma.resize(n);
+            vega.resize(n);
+        }
+    };
+
+    struct Chain {
+        SymbolId underlying;
+        std::vector<double> strike, expiry, volatility, call;
+        DoubleBuffer<Results> results;
+    };
+
+    double rate;
+    BlackScholesKernel kernel = blackScholesKernel();
+    std::vector<std::unique_ptr<Chain>> chains;
+    std::vector<uint32_t> chainOf; // Chain by underlying symbol id
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Price time priority limit order book for one symbol
+// Prices are integer ticks (the wire's fixed point), each side is a vector of price levels
+// sorted so the best level is at the back, each level is a FIFO of orders linked through
+// a node pool; resting orders are found by id through a hash index for cancels
+
+enum class TimeInForce : uint8_t { Day = 0, ImmediateOrCancel = 1 };
+
+class OrderBook {
+public:
+    static constexpr uint32_t none = ~uint32_t(0);
+
+    // A resting order, owner and tag are opaque to the book (e.g. session and client order id)
+    struct RestingOrder {
+        uint64_t id;
+        uint64_t owner;
+        uint64_t tag;
+        int64_t price;
+        int64_t quantity;
+        int8_t side;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    struct Level {
+        int64_t price;
+        int64_t quantity;
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    // Match an incoming order, then rest what is left unless it is immediate or cancel
+    // onFill(const RestingOrder &maker, int64_t price, int64_t quantity) runs for every fill,
+    // maker.quantity is already reduced by the fill; returns the quantity left unfilled
+    template <typename OnFill>
+    int64_t add(uint64_t id, uint64_t owner, uint64_t tag, int side, int64_t price, int64_t quantity,
+                TimeInForce timeInForce, OnFill &&onFill) {
+        if (side > 0) {
+            quantity = match(asks, quantity, [price](int64_t level) { return level <= price; }, onFill);
+            if (quantity > 0 && timeInForce == TimeInForce::Day) rest(bids, std::less<int64_t>(), id, owner, tag, 1, price, quantity);
+        } else {
+            quantity = match(bids, quantity, [price](int64_t level) { return level >= price; }, onFill);
+            if (quantity > 0 && timeInForce == TimeInForce::Day) rest(asks, std::greater<int64_t>(), id, owner, tag, -1, price, quantity);
+        }
+        return quantity;
+    }
+
+    // Remove a resting order, returns false if it is no longer in the book
+    bool cancel(uint64_t id, RestingOrder &cancelled) {
+        auto it = index.find(id);
+        if (it == index.end()) return false;
+        uint32_t node = it->second;
+        cancelled = nodes[node];
+        if (cancelled.side > 0) unlink(bids, std::less<int64_t>(), node);
+        else unlink(asks, std::greater<int64_t>(), node);
+        return true;
+    }
+
+    // Remove every resting order of an owner, returns how many there were
+    std::size_t cancelOwner(uint64_t owner) {
+        std::vector<uint64_t> ids;
+        for (const auto &entry : index) {
+            if (nodes[entry.second].owner == owner) ids.push_back(entry.first);
+        }
+        RestingOrder cancelled;
+        for (uint64_t id : ids) cancel(id, cancelled);
+        return ids.size();
+    }
+
+    // 0 when the side is empty
+    int64_t bestBid() const { return bids.empty() ? 0 : bids.back().price; }
+    int64_t bestAsk() const { return asks.empty() ? 0 : asks.back().price; }
+
+    std::size_t restingOrders() const { return index.size(); }
+
+private:
+    template <typename Crosses, typename OnFill>
+    int64_t match(std::vector<Level> &levels, int64_t quantity, Crosses crosses, OnFill &onFill) {
+        while (quantity > 0 && !levels.empty() && crosses(levels.back().price)) {
+            Level &level = levels.back();
+            while (quantity > 0 && level.head != none) {
+                uint32_t node = level.head;
+                RestingOrder &maker = nodes[node];
+                int64_t traded = std::min(quantity, maker.quantity);
+                maker.quantity -= traded;
+                level.quantity -= traded;
+                quantity -= traded;
+                onFill(static_cast<const RestingOrder &>(maker), level.price, traded);
+                if (maker.quantity == 0) {
+                    level.head = maker.next;
+                    if (level.head != none) nodes[level.head].prev = none;
+                    else level.tail = none;
+                    release(node);
+                }
+            }
+            if (level.head == none) levels.pop_back();
+        }
+        return quantity;
+    }
+
+    template <typename Worse>
+    void rest(std::vector<Level> &levels, Worse worse, uint64_t id, uint64_t owner, uint64_t tag,
+              int side, int64_t price, int64_t quantity) {
+        uint32_t node = acquire();
+        nodes[node] = RestingOrder{id, owner, tag, price, quantity, static_cast<int8_t>(side), none, none};
+        index.emplace(id, node);
+
+        // Levels run from worst to best, new orders mostly land near the back
+        auto it = std::lower_bound(levels.begin(), levels.end(), price,
+            [&worse](const Level &level, int64_t p) { return worse(level.price, p); });
+        if (it == levels.end() || it->price != price) {
+            it = levels.insert(it, Level{price, 0, none, none});
+        }
+        Level &level = *it;
+        level.quantity += quantity;
+        nodes[node].prev = level.tail;
+        if (level.tail != none) nodes[level.tail].next = node;
+        else level.head = node;
+        level.tail = node;
+    }
+
+    template <typename Worse>
+    void unlink(std::vector<Level> &levels, Worse worse, uint32_t node) {
+        RestingOrder &order = nodes[node];
+        auto it = std::lower_bound(levels.begin(), levels.end(), order.price,
+            [&worse](const Level &level, int64_t p) { return worse(level.price, p); });
+        Level &level = *it;
+        level.quantity -= order.quantity;
+        if (order.prev != none) nodes[order.prev].next = order.next;
+        else level.head = order.next;
+        if (order.next != none) nodes[order.next].prev = order.prev;
+        else level.tail = order.prev;
+        if (level.head == none) levels.erase(it);
+        release(node);
+    }
+
+    uint32_t acquire() {
+        if (!freeNodes.empty()) {
+            uint32_t node = freeNodes.back();
+            freeNodes.pop_back();
+            return node;
+        }
+        nodes.emplace_back();
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    void release(uint32_t node) {
+        index.erase(nodes[node].id);
+        freeNodes.push_back(node);
+    }
+
+    std::vector<Level> bids; // Ascending, best bid at the back
+    std::vector<Level> asks; // Descending, best ask at the back
+    std::vector<RestingOrder> nodes;
+    std::vector<uint32_t> freeNodes;
+    std::unordered_map<uint64_t, uint32_t> index;
+};
@@ -0,0 +1,215 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.h"
+#include "order_book.h"
+#include "order_wire.h"
+#include "price_history.h"
+#include "risk_check.h"
+#include "socket_util.h"
+#include "spsc_ring.h"
+
+// Order entry path: strategy threads push orders into their own SPSC ring, the gateway
+// thread drains the rings, runs the pre trade checks, encodes the survivors into one write
+// to the exchange and matches the acks, executions and cancels that come back
+// Handler supplies the hooks into the rest of the process as static functions, so they are
+// resolved at compile time:
+//     static double lastPrice(SymbolId);                  live price for the risk checks
+//     static void onMarketData(const WireMarketData &);   exchange market data
+//     static void onFill(const Order &, int64_t quantity, double price, int64_t timestamp);
+//     static void onBatchEnd(int64_t now);                after each pass over the exchange's messages
+// all of them run on the gateway thread
+// Measures tick to order (tick timestamp to the write) and order to ack (write to ack read)
+
+struct OutboundOrder {
+    Order order;
+    int64_t tickTimestamp; // Timestamp of the price update the strategy reacted to
+    TimeInForce timeInForce;
+};
+
+constexpr std::size_t orderRingCapacity = 4096;
+using OrderRing = SpscRing<OutboundOrder, orderRingCapacity>;
+
+template <typename Handler>
+class OrderGateway {
+public:
+    OrderGateway(const std::string &address, RiskEngine &risk)
+        : fd(connectTo(address)), risk(risk), pending(pendingCapacity) {
+        setNonBlocking(fd);
+    }
+
+    ~OrderGateway() { ::close(fd); }
+
+    OrderGateway(const OrderGateway&) = delete;
+    OrderGateway& operator=(const OrderGateway&) = delete;
+
+    // One ring per strategy thread, register them all before run()
+    OrderRing &addStrategy() {
+        rings.push_back(std::make_unique<OrderRing>());
+        return *rings.back();
+    }
+
+    // Gateway thread body, returns when running is cleared or the exchange goes away
+    void run(const std::atomic<bool> &running) {
+        std::vector<char> outbound;
+        outbound.reserve(maxBatch * sizeof(WireNewOrder));
+        int64_t nextReport = wallClockNanos() + 1000000000;
+
+        while (running.load(std::memory_order_relaxed)) {
+            int64_t now = wallClockNanos();
+            for (auto &ring : rings) {
+                OutboundOrder next;
+                for (std::size_t n = 0; n < maxBatch && ring->tryPop(next); ++n) submit(next, now, outbound);
+            }
+            bool busy = !outbound.empty();
+            if (busy) {
+                // One write for everything drained in this pass
+                if (!writeAll(fd, outbound.data(), outbound.size())) {
+                    std::cout << "Gateway: exchange connection lost" << std::endl;
+                    return;
+                }
+                outbound.clear();
+            }
+
+            if (!reader.readFrom(fd)) {
+                std::cout << "Gateway: exchange disconnected" << std::endl;
+                return;
+            }
+            int64_t received = wallClockNanos();
+            bool framed = reader.forEachMessage([&](const WireHeader &header, const char *message) {
+                busy = true;
+                if (header.type == WireAckType || header.type == WireRejectType) {
+                    WireAck ack;
+                    std::memcpy(&ack, message, sizeof(ack));
+                    onAck(ack, header.type == WireRejectType, received);
+                } else if (header.type == WireExecutionType || header.type == WireCancelledType) {
+                    WireExecution execution;
+                    std::memcpy(&execution, message, sizeof(execution));
+                    onExecution(execution, header.type == WireCancelledType);
+                } else if (header.type == WireMarketDataType) {
+                    WireMarketData update;
+                    std::memcpy(&update, message, sizeof(update));
+                    Handler::onMarketData(update);
+                }
+            });
+            if (!framed) {
+                std::cout << "Gateway: malformed message from exchange" << std::endl;
+                return;
+            }
+            Handler::onBatchEnd(received);
+
+            if (received >= nextReport) {
+                report();
+                nextReport = received + 1000000000;
+            }
+            if (!busy) std::this_thread::yield();
+        }
+    }
+
+    void report() {
+        std::cout << "Gateway: sent " << sent << " acked " << acked << " rejected " << rejected
+                  << " risk rejected " << riskRejected << " filled " << filledQuantity << " cancelled " << cancelledQuantity
+                  << " | tick to order p50 " << tickToOrder.percentile(50) << " ns p99 " << tickToOrder.percentile(99)
+                  << " ns | order to ack p50 " << orderToAck.percentile(50) << " ns p99 " << orderToAck.percentile(99)
+                  << " ns" << std::endl;
+        tickToOrder.reset();
+        orderToAck.reset();
+    }
+
+private:
+    static constexpr std::size_t maxBatch = 256;
+    static constexpr std::size_t pendingCapacity = 1 << 16; // Orders that can await an ack at once
+
+    struct PendingOrder {
+        Order order;
+        int64_t sendTime = 0;
+        int64_t leaves = 0;  // Quantity still working at the exchange
+        bool acked = false;
+        bool open = false;
+    };
+
+    void submit(OutboundOrder &next, int64_t now, std::vector<char> &outbound) {
+        Order &order = next.order;
+        order.orderId = nextOrderId++;
+        order.timestamp = now;
+        if (risk.check(order, Handler::lastPrice(order.symbol)) != 0) {
+            ++riskRejected;
+            return;
+        }
+
+        WireNewOrder message = makeWireMessage<WireNewOrder>(WireNewOrderType);
+        message.account = order.account;
+        message.orderId = order.orderId;
+        message.symbol = order.symbol;
+        message.side = static_cast<int8_t>(order.side);
+        message.timeInForce = static_cast<uint8_t>(next.timeInForce);
+        message.quantity = order.quantity;
+        message.price = priceToWire(order.price);
+        message.sendTime = now;
+        appendWireMessage(outbound, message);
+
+        PendingOrder &slot = pending[order.orderId & (pendingCapacity - 1)];
+        slot.order = order;
+        slot.sendTime = now;
+        slot.leaves = order.quantity;
+        slot.acked = false;
+        slot.open = true;
+        tickToOrder.record(now - next.tickTimestamp);
+        ++sent;
+    }
+
+    PendingOrder *find(uint64_t orderId) {
+        PendingOrder &slot = pending[orderId & (pendingCapacity - 1)];
+        return slot.open && slot.order.orderId == orderId ? &slot : nullptr;
+    }
+
+    void onAck(const WireAck &ack, bool isReject, int64_t received) {
+        PendingOrder *slot = find(ack.orderId);
+        if (!slot || slot->acked) return;
+        slot->acked = true;
+        orderToAck.record(received - slot->sendTime);
+        if (isReject) {
+            risk.onCancel(slot->order, slot->leaves);
+            slot->open = false;
+            ++rejected;
+        } else {
+            ++acked;
+        }
+    }
+
+    // Fills keep their position and release credit, cancelled quantity is undone entirely
+    void onExecution(const WireExecution &execution, bool isCancel) {
+        PendingOrder *slot = find(execution.orderId);
+        if (!slot) return;
+        if (isCancel) {
+            risk.onCancel(slot->order, execution.quantity);
+            cancelledQuantity += static_cast<uint64_t>(execution.quantity);
+        } else {
+            risk.onFill(slot->order, execution.quantity);
+            filledQuantity += static_cast<uint64_t>(execution.quantity);
+            Handler::onFill(slot->order, execution.quantity, priceFromWire(execution.price), execution.exchangeTime);
+        }
+        slot->leaves = execution.leavesQuantity;
+        if (slot->leaves == 0) slot->open = false;
+    }
+
+    int fd;
+    RiskEngine &risk;
+    std::vector<std::unique_ptr<OrderRing>> rings;
+    std::vector<PendingOrder> pending;
+    WireReader reader;
+    uint64_t nextOrderId = 1;
+    uint64_t sent = 0, acked = 0, rejected = 0, riskRejected = 0;
+    uint64_t filledQuantity = 0, cancelledQuantity = 0;
+    LatencyHistogram tickToOrder;
+    LatencyHistogram orderToAck;
+};
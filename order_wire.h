@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <sys/socket.h>
+
+// Binary order entry and market data protocol between the gateway and the exchange
+// Fixed size little endian messages, each starts with a WireHeader holding its total length,
+// prices are fixed point with four decimals, symbols are the dense ids of main's listing order
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "the wire structs are sent as they are in memory");
+
+constexpr const char *defaultExchangeAddress = "/tmp/lowlatency-exchange.sock";
+constexpr uint8_t wireVersion = 1;
+constexpr double wirePriceScale = 10000.0;
+constexpr unsigned wirePriceDecimals = 4; // Digits of wirePriceScale
+
+inline int64_t priceToWire(double price) { return std::llround(price * wirePriceScale); }
+inline double priceFromWire(int64_t price) { return static_cast<double>(price) / wirePriceScale; }
+
+enum WireMessageType : uint8_t {
+    WireNewOrderType = 1,
+    WireAckType = 2,        // Order accepted, it is now working
+    WireRejectType = 3,
+    WireExecutionType = 4,  // Part or all of an order traded
+    WireCancelledType = 5,  // Rest of an order was cancelled (immediate or cancel leftovers)
+    WireMarketDataType = 6, // Trade and top of book of a symbol, sent to every session
+};
+
+struct WireHeader {
+    uint16_t length;
+    uint8_t type;
+    uint8_t version;
+};
+
+struct WireNewOrder {
+    WireHeader header;
+    uint32_t account;
+    uint64_t orderId;
+    uint32_t symbol;
+    int8_t side;       // +1 buy, -1 sell
+    uint8_t timeInForce; // 0 day, 1 immediate or cancel
+    uint16_t reserved;
+    int64_t quantity;
+    int64_t price;
+    int64_t sendTime;  // Gateway clock, echoed back in the ack
+};
+static_assert(sizeof(WireNewOrder) == 48, "wire layout");
+
+// Ack and reject share a layout, reason is 0 for an ack
+struct WireAck {
+    WireHeader header;
+    uint32_t reason;
+    uint64_t orderId;
+    int64_t sendTime;
+    int64_t exchangeTime;
+};
+static_assert(sizeof(WireAck) == 32, "wire layout");
+
+// Execution and cancelled share a layout, quantity is what traded or was cancelled
+struct WireExecution {
+    WireHeader header;
+    uint32_t symbol;
+    uint64_t orderId;
+    int64_t quantity;
+    int64_t price;
+    int64_t leavesQuantity; // Still working after this message, 0 means the order is done
+    int64_t exchangeTime;
+};
+static_assert(sizeof(WireExecution) == 48, "wire layout");
+
+// lastQuantity is 0 when only the top of book changed, an empty side is sent as 0
+struct WireMarketData {
+    WireHeader header;
+    uint32_t symbol;
+    int64_t lastPrice;
+    int64_t lastQuantity;
+    int64_t bestBid;
+    int64_t bestAsk;
+    int64_t exchangeTime;
+};
+static_assert(sizeof(WireMarketData) == 48, "wire layout");
+
+template <typename Message>
+Message makeWireMessage(uint8_t type) {
+    Message message{};
+    message.header.length = sizeof(Message);
+    message.header.type = type;
+    message.header.version = wireVersion;
+    return message;
+}
+
+template <typename Message>
+void appendWireMessage(std::vector<char> &out, const Message &message) {
+    const char *bytes = reinterpret_cast<const char *>(&message);
+    out.insert(out.end(), bytes, bytes + sizeof(Message));
+}
+
+// Reassembles whole messages from a stream socket
+class WireReader {
+public:
+    explicit WireReader(std::size_t capacity = 1 << 16) : buffer(capacity) {}
+
+    // Read whatever is available, false when the peer closed or the socket failed
+    bool readFrom(int fd) {
+        if (begin > 0 && begin == end) begin = end = 0;
+        if (buffer.size() - end < 4096) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+        }
+        ssize_t n = ::recv(fd, buffer.data() + end, buffer.size() - end, 0);
+        if (n > 0) {
+            end += static_cast<std::size_t>(n);
+            return true;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR);
+    }
+
+    // Add bytes received some other way (e.g. by io_uring), false if they don't fit
+    bool append(const char *data, std::size_t length) {
+        if (buffer.size() - end < length) {
+            std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+            end -= begin;
+            begin = 0;
+            if (buffer.size() - end < length) return false;
+        }
+        std::memcpy(buffer.data() + end, data, length);
+        end += length;
+        return true;
+    }
+
+    // Calls fn(const WireHeader &header, const char *message) for every complete message
+    // Returns false on a malformed header, the stream can't be resynchronised after that
+    template <typename Fn>
+    bool forEachMessage(Fn &&fn) {
+        while (end - begin >= sizeof(WireHeader)) {
+            WireHeader header;
+            std::memcpy(&header, buffer.data() + begin, sizeof(header));
+            if (header.length < sizeof(WireHeader) || header.length > buffer.size() / 2) return false;
+            if (end - begin < header.length) break;
+            fn(header, buffer.data() + begin);
+            begin += header.length;
+        }
+        return true;
+    }
+
+    // For streams framed some other way: calls fn(const char *data, std::size_t length) with the
+    // bytes not used yet, fn returns how many of them it used
+    template <typename Fn>
+    void consume(Fn &&fn) {
+        begin += fn(static_cast<const char *>(buffer.data() + begin), end - begin);
+    }
+
+private:
+    std::vector<char> buffer;
+    std::size_t begin = 0;
+    std::size_t end = 0;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+
+#include <immintrin.h>
+
+#include "cpu_dispatch.h"
+
+// Delimiter search for text parsing (CSV fields, lines)
+// findDelimiter(p, end, a, b) returns the first position in [p, end) holding a or b, or end
+
+using FindDelimiterFn = const char *(*)(const char *, const char *, char, char);
+
+inline const char *findDelimiterScalar(const char *p, const char *end, char a, char b) {
+    for (; p < end; ++p) {
+        if (*p == a || *p == b) return p;
+    }
+    return end;
+}
+
+__attribute__((target("sse4.2")))
+inline const char *findDelimiterSse42(const char *p, const char *end, char a, char b) {
+    const __m128i needles = _mm_setr_epi8(a, b, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int index = _mm_cmpestri(needles, 2, chunk, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT);
+        if (index < 16) return p + index;
+    }
+    return findDelimiterScalar(p, end, a, b);
+}
+
+__attribute__((target("avx2")))
+inline const char *findDelimiterAvx2(const char *p, const char *end, char a, char b) {
+    const __m256i first = _mm256_set1_epi8(a), second = _mm256_set1_epi8(b);
+    for (; end - p >= 32; p += 32) {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, first), _mm256_cmpeq_epi8(chunk, second));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+        if (mask) return p + __builtin_ctz(mask);
+    }
+    return findDelimiterScalar(p, end, a, b);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl,bmi2")))
+inline const char *findDelimiterAvx512(const char *p, const char *end, char a, char b) {
+    const __m512i first = _mm512_set1_epi8(a), second = _mm512_set1_epi8(b);
+    while (p < end) {
+        std::size_t left = static_cast<std::size_t>(end - p);
+        // Masked load for the tail, lanes past end are never touched
+        __mmask64 valid = left >= 64 ? ~__mmask64(0) : _bzhi_u64(~0ull, static_cast<unsigned>(left));
+        __m512i chunk = _mm512_maskz_loadu_epi8(valid, p);
+        __mmask64 hits = (_mm512_cmpeq_epi8_mask(chunk, first) | _mm512_cmpeq_epi8_mask(chunk, second)) & valid;
+        if (hits) return p + __builtin_ctzll(hits);
+        p += 64;
+    }
+    return end;
+}
+
+inline const FindDelimiterFn findDelimiter =
+    selectKernel<FindDelimiterFn>(findDelimiterScalar, findDelimiterSse42, findDelimiterAvx2, findDelimiterAvx512);
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Wall clock timestamp in nanoseconds since epoch, used to stamp every price update
+inline int64_t wallClockNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// One recorded price update, seq starts at 1 and increases by one per update
+struct PriceTick {
+    double price = 0.0;
+    int64_t timestamp = 0;
+    uint64_t seq = 0;
+};
+
+// Fixed size lock free ring of the last Depth updates of one symbol
+// Single writer (the applier), any number of readers, readers never block the writer
+// Each slot is a small seqlock: stamp is 0 while being written and the tick seq once complete,
+// so a reader can tell a torn or overwritten slot apart from the tick it expected
+// Timestamps must be non decreasing per symbol, the time travel lookup binary searches on them
+template <std::size_t Depth>
+class PriceHistory {
+    static_assert(Depth >= 2 && (Depth & (Depth - 1)) == 0, "Depth must be a power of two");
+
+public:
+    PriceHistory() = default;
+    PriceHistory(const PriceHistory&) = delete;
+    PriceHistory& operator=(const PriceHistory&) = delete;
+
+    static constexpr std::size_t capacity() { return Depth; }
+
+    // Writer side, only one thread may call this for a given symbol
+    void record(double price, int64_t timestamp) {
+        uint64_t seq = head.load(std::memory_order_relaxed) + 1;
+        Slot &slot = slots[(seq - 1) & (Depth - 1)];
+        slot.stamp.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.price.store(price, std::memory_order_relaxed);
+        slot.timestamp.store(timestamp, std::memory_order_relaxed);
+        slot.stamp.store(seq, std::memory_order_release);
+        head.store(seq, std::memory_order_release);
+    }
+
+    // Seq of the newest tick, 0 when nothing was recorded yet
+    uint64_t lastSeq() const { return head.load(std::memory_order_acquire); }
+
+    // Copy up to n of the newest ticks into out, oldest first, returns how many were copied
+    // Ticks overwritten by the writer while copying are dropped from the front
+    std::size_t lastTicks(std::size_t n, PriceTick *out) const {
+        uint64_t newest = head.load(std::memory_order_acquire);
+        if (n > Depth) n = Depth;
+        if (n > newest) n = static_cast<std::size_t>(newest);
+        uint64_t first = newest - n + 1;
+
+        std::size_t count = 0;
+        for (uint64_t seq = first; seq <= newest; ++seq) {
+            if (!read(seq, out[count])) {
+                count = 0; // lapped, everything older is gone as well
+                continue;
+            }
+            ++count;
+        }
+        return count;
+    }
+
+    // Price in effect at time t: the newest tick with timestamp <= t
+    // Returns false if t is older than everything still in the ring or nothing was recorded
+    bool priceAsOf(int64_t t, PriceTick &out) const {
+        for (int attempt = 0; attempt < 4; ++attempt) {
+            uint64_t newest = head.load(std::memory_order_acquire);
+            if (newest == 0) return false;
+            // Leave one slot of slack so the oldest probe is not overwritten by the next record
+            uint64_t oldest = newest > Depth - 1 ? newest - (Depth - 1) + 1 : 1;
+
+            PriceTick probe;
+            bool lapped = false;
+            uint64_t lo = oldest, hi = newest, found = 0;
+            while (lo <= hi) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                if (!read(mid, probe)) { lapped = true; break; }
+                if (probe.timestamp <= t) { found = mid; out = probe; lo = mid + 1; }
+                else { hi = mid - 1; }
+            }
+            if (lapped) continue;
+            if (found == 0) return false;
+            // Re-validate the answer, it may have been overwritten after the probe
+            if (read(found, out)) return true;
+        }
+        return false;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> stamp{0};
+        std::atomic<double> price{0.0};
+        std::atomic<int64_t> timestamp{0};
+    };
+
+    // Seqlock read of the slot holding seq, false if it is being written or holds another tick
+    bool read(uint64_t seq, PriceTick &out) const {
+        const Slot &slot = slots[(seq - 1) & (Depth - 1)];
+        uint64_t before = slot.stamp.load(std::memory_order_acquire);
+        double price = slot.price.load(std::memory_order_relaxed);
+        int64_t timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.stamp.load(std::memory_order_relaxed);
+        if (before != seq || after != seq) return false;
+        out.price = price;
+        out.timestamp = timestamp;
+        out.seq = seq;
+        return true;
+    }
+
+    alignas(64) std::atomic<uint64_t> head{0};
+    Slot slots[Depth];
+};
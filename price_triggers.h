@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "symbols.h"
+
+// Price triggers: "tell me when SYMBOL trades at or through P", for alerts and stop orders
+// Each symbol keeps one sorted array per direction with the next trigger to fire at the back:
+//     rising  (fires at price >= level) sorted by level descending, the lowest level last
+//     falling (fires at price <= level) sorted by level ascending, the highest level last
+// so a price update checks the back of each array and pops the k crossed triggers in O(k), an
+// update that crosses nothing costs two compares
+// Adding or cancelling finds the position by binary search and shifts the array, triggers at the
+// same level fire in the order they were added
+// Single threaded: the thread applying prices owns the index, triggers it fires are removed
+enum class TriggerDirection : uint8_t {
+    Rising,  // Price went up to the level or past it
+    Falling, // Price went down to the level or past it
+};
+
+template <typename Payload>
+class TriggerIndex {
+public:
+    // Returns the trigger's id, ids start at 1
+    uint64_t add(SymbolId symbol, TriggerDirection direction, double level, const Payload &payload) {
+        if (symbol >= books.size()) books.resize(symbol + 1);
+        std::vector<Entry> &side = books[symbol].side(direction);
+        uint64_t id = nextId++;
+        // Before the triggers already at this level, which are closer to the back and fire first
+        auto before = direction == TriggerDirection::Rising
+            ? std::lower_bound(side.begin(), side.end(), level, [](const Entry &e, double l) { return e.level > l; })
+            : std::lower_bound(side.begin(), side.end(), level, [](const Entry &e, double l) { return e.level < l; });
+        side.insert(before, Entry{level, id, payload});
+        locations.emplace(id, Location{symbol, direction, level});
+        return id;
+    }
+
+    // False when the trigger already fired or was cancelled
+    bool cancel(uint64_t id) {
+        auto it = locations.find(id);
+        if (it == locations.end()) return false;
+        Location location = it->second;
+        locations.erase(it);
+        std::vector<Entry> &side = books[location.symbol].side(location.direction);
+        auto range = location.direction == TriggerDirection::Rising
+            ? std::equal_range(side.begin(), side.end(), Entry{location.level, 0, Payload{}}, [](const Entry &a, const Entry &b) { return a.level > b.level; })
+            : std::equal_range(side.begin(), side.end(), Entry{location.level, 0, Payload{}}, [](const Entry &a, const Entry &b) { return a.level < b.level; });
+        side.erase(std::find_if(range.first, range.second, [id](const Entry &e) { return e.id == id; }));
+        return true;
+    }
+
+    // Fires fn(id, level, payload) for every trigger price crossed, lowest rising and highest
+    // falling level first; fn may add and cancel triggers, added ones are checked from the next
+    // price on
+    template <typename Fn>
+    void onPrice(SymbolId symbol, double price, Fn &&fn) {
+        if (symbol >= books.size()) return;
+        // Take the crossed ones off both sides before any fires, adding from fn can grow books
+        Book &book = books[symbol];
+        fired.clear();
+        take(book.rising, [price](double level) { return price >= level; });
+        take(book.falling, [price](double level) { return price <= level; });
+        if (fired.empty()) return;
+        for (const Entry &entry : fired) locations.erase(entry.id); // Cancelling them from fn returns false
+        for (const Entry &entry : fired) fn(entry.id, entry.level, entry.payload);
+    }
+
+    std::size_t size() const { return locations.size(); }
+
+private:
+    struct Entry {
+        double level;
+        uint64_t id;
+        Payload payload;
+    };
+
+    struct Book {
+        std::vector<Entry> rising;
+        std::vector<Entry> falling;
+
+        std::vector<Entry> &side(TriggerDirection direction) { return direction == TriggerDirection::Rising ? rising : falling; }
+    };
+
+    struct Location {
+        SymbolId symbol;
+        TriggerDirection direction;
+        double level;
+    };
+
+    template <typename Crossed>
+    void take(std::vector<Entry> &side, Crossed crossed) {
+        while (!side.empty() && crossed(side.back().level)) {
+            fired.push_back(side.back());
+            side.pop_back();
+        }
+    }
+
+    std::vector<Book> books; // By symbol id
+    std::unordered_map<uint64_t, Location> locations;
+    std::vector<Entry> fired; // Scratch of the crossed triggers
+    uint64_t nextId = 1;
+};
@@ -0,0 +1,159 @@
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include "latency_histogram.h"
+#include "price_history.h"
+#include "query_server.h"
+#include "socket_util.h"
+#include "uring_query_server.h"
+
+// Compares the epoll and io_uring query server backends on the fan out of one symbol's price
+// to many subscribers over a Unix socket, in one process with a synthetic price source
+// Each update waits until every subscriber has it before the next, so every update is one
+// fan out pass; reports the server's system calls per update and the publish to first and
+// last subscriber latency
+// Usage:
+//   ./query_bench [--subscribers N] [--updates N] [--backend epoll|uring|both]
+
+const std::string benchAddress = "/tmp/lowlatency-query-bench.sock";
+
+PriceHistory<64> benchPrices;
+
+struct BenchSource {
+    static SymbolId find(const std::string &name) { return name == "BENCH" ? 0 : invalidSymbol; }
+    static std::size_t symbolCount() { return 1; }
+    static uint64_t lastSeq(SymbolId) { return benchPrices.lastSeq(); }
+    static bool latest(SymbolId, PriceTick &out) { return benchPrices.lastTicks(1, &out) == 1; }
+};
+
+struct BenchResult {
+    uint64_t systemCalls = 0;
+    LatencyHistogram first;
+    LatencyHistogram last;
+};
+
+// Subscribers on the client side of the sockets, read through their own epoll set
+class Subscribers {
+public:
+    explicit Subscribers(std::size_t count) : epollFd(epoll_create1(EPOLL_CLOEXEC)), readers(count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            int fd = connectTo(benchAddress);
+            setNonBlocking(fd);
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = i;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+            fds.push_back(fd);
+            QuerySubscribe request = makeWireMessage<QuerySubscribe>(QuerySubscribeType);
+            request.requestId = 1;
+            request.symbol = 0;
+            request.subscribe = 1;
+            writeAll(fd, &request, sizeof(request));
+        }
+    }
+
+    ~Subscribers() {
+        for (int fd : fds) ::close(fd);
+        ::close(epollFd);
+    }
+
+    // Waits until every subscriber has a price with seq, records when the first and last got it
+    void waitFor(uint64_t seq, BenchResult *result) {
+        std::size_t pending = fds.size();
+        int64_t published = 0;
+        bool first = true;
+        std::vector<uint64_t> seen(fds.size(), 0);
+        epoll_event events[256];
+        while (pending > 0) {
+            int ready = epoll_wait(epollFd, events, 256, 1000);
+            if (ready <= 0) throw std::runtime_error("subscribers stopped receiving");
+            int64_t now = wallClockNanos();
+            for (int i = 0; i < ready; ++i) {
+                std::size_t index = events[i].data.u64;
+                if (!readers[index].readFrom(fds[index])) throw std::runtime_error("query server closed a subscriber");
+                readers[index].forEachMessage([&](const WireHeader &header, const char *message) {
+                    if (header.type != QueryPriceType) return;
+                    QueryPrice price;
+                    std::memcpy(&price, message, sizeof(price));
+                    if (price.seq < seq || seen[index] >= seq) return;
+                    seen[index] = price.seq;
+                    published = price.timestamp;
+                    if (result && first) result->first.record(now - published);
+                    first = false;
+                    --pending;
+                });
+            }
+            if (pending == 0 && result) result->last.record(now - published);
+        }
+    }
+
+private:
+    int epollFd;
+    std::vector<int> fds;
+    std::vector<WireReader> readers;
+};
+
+template <typename Server>
+BenchResult runBackend(std::size_t subscriberCount, std::size_t updates) {
+    BenchResult result;
+    std::atomic<bool> running{true};
+    auto server = std::make_unique<Server>(std::vector<std::string>{benchAddress});
+    std::thread serverThread([&] { server->run(running); });
+    {
+        Subscribers subscribers(subscriberCount);
+        subscribers.waitFor(benchPrices.lastSeq(), nullptr);
+        for (std::size_t i = 0; i < updates; ++i) {
+            benchPrices.record(100.0 + static_cast<double>(i % 100) * 0.01, wallClockNanos());
+            subscribers.waitFor(benchPrices.lastSeq(), &result);
+        }
+    }
+    running = false;
+    serverThread.join();
+    result.systemCalls = server->systemCalls();
+    return result;
+}
+
+// Runs the backend without updates first, so connecting and subscribing can be taken out
+template <typename Server>
+void report(const std::string &name, std::size_t subscriberCount, std::size_t updates) {
+    uint64_t setupCalls = runBackend<Server>(subscriberCount, 0).systemCalls;
+    BenchResult result = runBackend<Server>(subscriberCount, updates);
+    double perUpdate = updates ? static_cast<double>(result.systemCalls - std::min(setupCalls, result.systemCalls)) / updates : 0.0;
+    std::cout << std::left << std::setw(6) << name << std::right << std::fixed << std::setprecision(1)
+              << " system calls per update " << std::setw(8) << perUpdate
+              << "   first p50 " << std::setw(8) << result.first.percentile(50) << " ns"
+              << "   last p50 " << std::setw(9) << result.last.percentile(50) << " ns p99 " << std::setw(9)
+              << result.last.percentile(99) << " ns" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    std::size_t subscriberCount = 1000;
+    std::size_t updates = 1000;
+    std::string backend = "both";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string arg = argv[i];
+        if (arg == "--subscribers") subscriberCount = std::stoull(argv[i + 1]);
+        else if (arg == "--updates") updates = std::stoull(argv[i + 1]);
+        else if (arg == "--backend") backend = argv[i + 1];
+    }
+
+    // Both ends of every connection live in this process
+    rlimit files{};
+    getrlimit(RLIMIT_NOFILE, &files);
+    files.rlim_cur = files.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &files);
+
+    benchPrices.record(100.0, wallClockNanos());
+    std::cout << subscriberCount << " subscribers, " << updates << " updates" << std::endl;
+    if (backend != "uring") report<QueryServer<BenchSource>>("epoll", subscriberCount, updates);
+    if (backend != "epoll") report<UringQueryServer<BenchSource>>("uring", subscriberCount, updates);
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "latency_histogram.h"
+#include "price_history.h"
+#include "query_wire.h"
+#include "socket_util.h"
+#include "text_codec.h"
+
+// Command line client for main's query server (main --serve ADDRESS)
+// Usage:
+//   ./query_client [--address ADDRESS] SYMBOL...              latest prices, one multi get
+//   ./query_client [--address ADDRESS] --subscribe SYMBOL...  print every pushed price until Ctrl + c
+//   ./query_client [--address ADDRESS] --bench N SYMBOL...    N multi gets, report the round trip
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void handleSignal(int) {
+    stopRequested = 1;
+}
+
+// Blocking request/reply helper over one connection
+class QueryClient {
+public:
+    explicit QueryClient(const std::string &address) : fd(connectTo(address)) {}
+    ~QueryClient() { ::close(fd); }
+
+    template <typename Message>
+    void send(const Message &message) {
+        if (!writeAll(fd, &message, sizeof(message))) throw std::runtime_error("query server went away");
+    }
+
+    // Waits for messages and calls fn(const WireHeader &, const char *) until it returns false
+    template <typename Fn>
+    void receive(Fn &&fn) {
+        bool more = true;
+        while (more && !stopRequested) {
+            if (!reader.readFrom(fd)) throw std::runtime_error("query server went away");
+            bool framed = reader.forEachMessage([&](const WireHeader &header, const char *message) {
+                if (more) more = fn(header, message);
+            });
+            if (!framed) throw std::runtime_error("malformed message from query server");
+        }
+    }
+
+    uint32_t lookup(const std::string &name) {
+        QueryLookup request = makeWireMessage<QueryLookup>(QueryLookupType);
+        request.requestId = ++lastRequest;
+        std::strncpy(request.name, name.c_str(), querySymbolLength - 1);
+        send(request);
+        uint32_t symbol = invalidId;
+        receive([&](const WireHeader &header, const char *message) {
+            if (header.type != QuerySymbolInfoType) return true;
+            QuerySymbolInfo info;
+            std::memcpy(&info, message, sizeof(info));
+            symbol = info.symbol;
+            return false;
+        });
+        return symbol;
+    }
+
+    static constexpr uint32_t invalidId = ~uint32_t(0);
+    uint32_t lastRequest = 0;
+
+private:
+    int fd;
+    WireReader reader;
+};
+
+void printPrice(const QueryPrice &price, const std::vector<std::string> &names, const std::vector<uint32_t> &ids) {
+    auto it = std::find(ids.begin(), ids.end(), price.symbol);
+    const std::string &name = names[it - ids.begin()];
+    if (price.status == QueryOk) {
+        std::string line = "Stock: " + name + " Price: $";
+        appendFixed(line, price.price, wirePriceDecimals); // Exactly the wire's fixed point value
+        line.append(" seq ");
+        appendInteger(line, price.seq);
+        std::cout << line << std::endl;
+    } else {
+        std::cout << "Stock: " << name << (price.status == QueryNoPrice ? " has no price yet" : " not found") << std::endl;
+    }
+}
+
+int main(int argc, char **argv) {
+    std::string address = defaultQueryAddress;
+    bool subscribe = false;
+    std::size_t benchRounds = 0;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--address" && i + 1 < argc) address = argv[++i];
+        else if (arg == "--subscribe") subscribe = true;
+        else if (arg == "--bench" && i + 1 < argc) benchRounds = std::stoull(argv[++i]);
+        else names.push_back(arg);
+    }
+    if (names.empty()) names = {"AAPL", "GOOGL", "MSFT"};
+    if (names.size() > queryMaxGet) names.resize(queryMaxGet);
+    std::signal(SIGINT, handleSignal);
+
+    QueryClient client(address);
+    std::vector<uint32_t> ids;
+    for (const auto &name : names) {
+        ids.push_back(client.lookup(name));
+        if (ids.back() == QueryClient::invalidId) std::cout << "Stock not found: " << name << std::endl;
+    }
+
+    QueryGet get = makeWireMessage<QueryGet>(QueryGetType);
+    get.count = static_cast<uint32_t>(ids.size());
+    std::copy(ids.begin(), ids.end(), get.symbols);
+
+    if (subscribe) {
+        for (uint32_t id : ids) {
+            QuerySubscribe request = makeWireMessage<QuerySubscribe>(QuerySubscribeType);
+            request.requestId = ++client.lastRequest;
+            request.symbol = id;
+            request.subscribe = 1;
+            client.send(request);
+        }
+        client.receive([&](const WireHeader &header, const char *message) {
+            if (header.type != QueryPriceType) return true;
+            QueryPrice price;
+            std::memcpy(&price, message, sizeof(price));
+            printPrice(price, names, ids);
+            return true;
+        });
+        return 0;
+    }
+
+    LatencyHistogram roundTrip;
+    for (std::size_t round = 0; round < std::max<std::size_t>(benchRounds, 1); ++round) {
+        get.requestId = ++client.lastRequest;
+        int64_t start = wallClockNanos();
+        client.send(get);
+        std::size_t replies = 0;
+        client.receive([&](const WireHeader &header, const char *message) {
+            if (header.type != QueryPriceType) return true;
+            QueryPrice price;
+            std::memcpy(&price, message, sizeof(price));
+            if (price.requestId != get.requestId) return true;
+            if (benchRounds == 0) printPrice(price, names, ids);
+            return ++replies < ids.size();
+        });
+        roundTrip.record(wallClockNanos() - start);
+    }
+    if (benchRounds > 0) {
+        std::cout << benchRounds << " multi gets of " << ids.size() << " symbols, round trip p50 " << roundTrip.percentile(50)
+                  << " ns p99 " << roundTrip.percentile(99) << " ns max " << roundTrip.max() << " ns" << std::endl;
+    }
+    return 0;
+}
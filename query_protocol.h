@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "price_history.h"
+#include "query_wire.h"
+#include "symbols.h"
+
+// The part of the query server that doesn't depend on how bytes move: answers requests and keeps
+// the subscriptions; the epoll (query_server.h) and io_uring (uring_query_server.h) backends own
+// the sockets and call it with each connection's received bytes
+// A backend takes any protocol with the same three members (handle, disconnect, forEachUpdate),
+// websocket_protocol.h is the other one
+// Subscriptions are conflated: each pass pushes the newest price of every symbol that changed,
+// rendered once for all of its subscribers
+// Source supplies the prices as static functions:
+//     static SymbolId find(const std::string &name);
+//     static std::size_t symbolCount();
+//     static uint64_t lastSeq(SymbolId);                 cheap change check, 0 before the first update
+//     static bool latest(SymbolId, PriceTick &out);      false when there is no price yet
+
+// Who subscribed to what, shared by the protocols
+// Connections are identified by an integer the backend picks, unique among open connections
+template <typename Source>
+class Subscriptions {
+public:
+    // Adds or removes connection from symbol's subscribers, false for an unknown symbol
+    bool update(int connection, SymbolId symbol, bool subscribe) {
+        if (symbol >= Source::symbolCount()) return false;
+        if (symbol >= subscribers.size()) {
+            subscribers.resize(Source::symbolCount());
+            pushedSeq.resize(Source::symbolCount(), 0);
+        }
+        auto &list = subscribers[symbol];
+        auto found = std::find(list.begin(), list.end(), connection);
+        auto &mine = subscriptions[connection];
+        if (subscribe && found == list.end()) {
+            list.push_back(connection);
+            mine.push_back(symbol);
+            if (list.size() == 1) pushedSeq[symbol] = Source::lastSeq(symbol);
+        } else if (!subscribe && found != list.end()) {
+            list.erase(found);
+            mine.erase(std::find(mine.begin(), mine.end(), symbol));
+        }
+        return true;
+    }
+
+    // Forget a closed connection's subscriptions
+    void disconnect(int connection) {
+        auto it = subscriptions.find(connection);
+        if (it == subscriptions.end()) return;
+        for (SymbolId symbol : it->second) {
+            auto &list = subscribers[symbol];
+            list.erase(std::find(list.begin(), list.end(), connection));
+        }
+        subscriptions.erase(it);
+    }
+
+    // Calls fn(SymbolId, const std::vector<int> &connections) for every subscribed symbol whose
+    // price changed since the last call
+    template <typename Fn>
+    void forEachChanged(Fn &&fn) {
+        for (SymbolId symbol = 0; symbol < subscribers.size(); ++symbol) {
+            if (subscribers[symbol].empty()) continue;
+            uint64_t seq = Source::lastSeq(symbol);
+            if (seq == pushedSeq[symbol]) continue;
+            pushedSeq[symbol] = seq;
+            fn(symbol, static_cast<const std::vector<int> &>(subscribers[symbol]));
+        }
+    }
+
+private:
+    std::vector<std::vector<int>> subscribers;                     // By symbol id
+    std::vector<uint64_t> pushedSeq;                               // By symbol id, seq of the last push
+    std::unordered_map<int, std::vector<SymbolId>> subscriptions;  // By connection
+};
+
+template <typename Source>
+class QueryProtocol {
+public:
+    // Answers every complete request in reader by appending to out, false on a malformed request
+    bool handle(int connection, WireReader &reader, std::vector<char> &out) {
+        bool valid = true;
+        bool framed = reader.forEachMessage([&](const WireHeader &header, const char *message) {
+            if (!valid) return;
+            if (header.type == QueryLookupType && header.length == sizeof(QueryLookup)) {
+                QueryLookup lookup;
+                std::memcpy(&lookup, message, sizeof(lookup));
+                onLookup(lookup, out);
+            } else if (header.type == QueryGetType && header.length == sizeof(QueryGet)) {
+                QueryGet get;
+                std::memcpy(&get, message, sizeof(get));
+                if (get.count > queryMaxGet) valid = false;
+                else for (uint32_t i = 0; i < get.count; ++i) appendWireMessage(out, renderPrice(get.requestId, get.symbols[i]));
+            } else if (header.type == QuerySubscribeType && header.length == sizeof(QuerySubscribe)) {
+                QuerySubscribe subscribe;
+                std::memcpy(&subscribe, message, sizeof(subscribe));
+                subscriptions.update(connection, subscribe.symbol, subscribe.subscribe != 0);
+                appendWireMessage(out, renderPrice(subscribe.requestId, subscribe.symbol));
+            } else {
+                valid = false;
+            }
+        });
+        return framed && valid;
+    }
+
+    void disconnect(int connection) { subscriptions.disconnect(connection); }
+
+    // Calls fn(const char *bytes, std::size_t length, const std::vector<int> &connections) for every
+    // subscribed symbol whose price changed since the last call, bytes is the rendered push
+    template <typename Fn>
+    void forEachUpdate(Fn &&fn) {
+        subscriptions.forEachChanged([&fn](SymbolId symbol, const std::vector<int> &connections) {
+            QueryPrice update = renderPrice(0, symbol);
+            fn(reinterpret_cast<const char *>(&update), sizeof(update), connections);
+        });
+    }
+
+private:
+    static void onLookup(const QueryLookup &lookup, std::vector<char> &out) {
+        QuerySymbolInfo info = makeWireMessage<QuerySymbolInfo>(QuerySymbolInfoType);
+        info.requestId = lookup.requestId;
+        std::memcpy(info.name, lookup.name, querySymbolLength);
+        info.name[querySymbolLength - 1] = 0;
+        info.symbol = Source::find(info.name);
+        appendWireMessage(out, info);
+    }
+
+    static QueryPrice renderPrice(uint32_t requestId, SymbolId symbol) {
+        QueryPrice reply = makeWireMessage<QueryPrice>(QueryPriceType);
+        reply.requestId = requestId;
+        reply.symbol = symbol;
+        PriceTick tick;
+        if (symbol >= Source::symbolCount()) {
+            reply.status = QueryUnknownSymbol;
+        } else if (!Source::latest(symbol, tick)) {
+            reply.status = QueryNoPrice;
+        } else {
+            reply.status = QueryOk;
+            reply.price = priceToWire(tick.price);
+            reply.timestamp = tick.timestamp;
+            reply.seq = tick.seq;
+        }
+        return reply;
+    }
+
+    Subscriptions<Source> subscriptions;
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/epoll.h>
+
+#include "price_history.h"
+#include "query_protocol.h"
+#include "socket_util.h"
+#include "symbols.h"
+
+// Epoll backend of the query server (query_protocol.h) on one thread, also serves the WebSocket
+// gateway (websocket_protocol.h) as Protocol
+// Listens on every given address (TCP and Unix sockets alike) through one epoll set; replies
+// and pushes produced in a pass are written with one send per connection at the end of the pass,
+// a connection that can't take them keeps the rest buffered and is woken by EPOLLOUT, one that
+// falls maxOutbound bytes behind is dropped
+
+template <typename Source, typename Protocol = QueryProtocol<Source>>
+class QueryServer {
+public:
+    static constexpr std::size_t maxOutbound = 1 << 20;
+
+    explicit QueryServer(const std::vector<std::string> &addresses) : epollFd(epoll_create1(EPOLL_CLOEXEC)) {
+        for (const auto &address : addresses) {
+            int fd = listenOn(address);
+            setNonBlocking(fd);
+            watch(fd, EPOLLIN);
+            listeners.push_back(fd);
+            unixPaths.push_back(isTcpAddress(address) ? std::string() : address);
+        }
+    }
+
+    ~QueryServer() {
+        for (auto &entry : connections) ::close(entry.first);
+        for (int fd : listeners) ::close(fd);
+        for (const auto &path : unixPaths) {
+            if (!path.empty()) ::unlink(path.c_str());
+        }
+        ::close(epollFd);
+    }
+
+    QueryServer(const QueryServer&) = delete;
+    QueryServer& operator=(const QueryServer&) = delete;
+
+    // Server thread body, returns when running is cleared
+    void run(const std::atomic<bool> &running) {
+        epoll_event events[256];
+        while (running.load(std::memory_order_relaxed)) {
+            int ready = epoll_wait(epollFd, events, 256, 1);
+            ++calls;
+            for (int i = 0; i < ready; ++i) {
+                int fd = events[i].data.fd;
+                if (std::find(listeners.begin(), listeners.end(), fd) != listeners.end()) {
+                    accept(fd);
+                    continue;
+                }
+                auto it = connections.find(fd);
+                if (it == connections.end()) continue;
+                Connection &connection = *it->second;
+                if (events[i].events & EPOLLOUT) markDirty(connection);
+                if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !connection.closing && !receive(connection)) {
+                    connection.closing = true; // After this pass's flush, so a last reply still goes out
+                    markDirty(connection);
+                }
+            }
+            pushUpdates();
+            flush();
+        }
+    }
+
+    std::size_t connectionCount() const { return connections.size(); }
+
+    // System calls made by the server loop so far, to compare backends
+    uint64_t systemCalls() const { return calls; }
+
+private:
+    struct Connection {
+        int fd;
+        WireReader reader{8192};
+        std::vector<char> outbound;
+        std::size_t sent = 0;          // Bytes of outbound already written
+        bool dirty = false;            // Has something to write this pass
+        bool waitingForOutput = false; // EPOLLOUT is armed
+        bool closing = false;
+    };
+
+    void watch(int fd, uint32_t events, int op = EPOLL_CTL_ADD) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, op, fd, &event);
+    }
+
+    void accept(int listener) {
+        int fd;
+        while ((fd = ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            ++calls;
+            setNoDelay(fd);
+            watch(fd, EPOLLIN);
+            auto connection = std::make_unique<Connection>();
+            connection->fd = fd;
+            connections[fd] = std::move(connection);
+        }
+    }
+
+    // Read and answer everything the client sent, false when it should be closed
+    bool receive(Connection &connection) {
+        ++calls;
+        if (!connection.reader.readFrom(connection.fd)) return false;
+        bool valid = protocol.handle(connection.fd, connection.reader, connection.outbound);
+        if (!connection.outbound.empty()) markDirty(connection);
+        return valid;
+    }
+
+    void pushUpdates() {
+        protocol.forEachUpdate([this](const char *bytes, std::size_t length, const std::vector<int> &subscribers) {
+            for (int fd : subscribers) {
+                Connection &connection = *connections[fd];
+                connection.outbound.insert(connection.outbound.end(), bytes, bytes + length);
+                markDirty(connection);
+            }
+        });
+    }
+
+    void markDirty(Connection &connection) {
+        if (connection.dirty) return;
+        connection.dirty = true;
+        dirty.push_back(connection.fd);
+    }
+
+    // One send per connection for everything queued in this pass
+    void flush() {
+        for (int fd : dirty) {
+            auto it = connections.find(fd);
+            if (it == connections.end()) continue;
+            Connection &connection = *it->second;
+            connection.dirty = false;
+            if (!write(connection)) connection.closing = true;
+        }
+        for (int fd : dirty) {
+            auto it = connections.find(fd);
+            if (it != connections.end() && it->second->closing) close(fd);
+        }
+        dirty.clear();
+    }
+
+    // Write what the socket takes, false when the client is gone or too far behind
+    bool write(Connection &connection) {
+        std::size_t pending = connection.outbound.size() - connection.sent;
+        while (pending > 0) {
+            ssize_t n = ::send(connection.fd, connection.outbound.data() + connection.sent, pending, MSG_NOSIGNAL);
+            ++calls;
+            if (n > 0) {
+                connection.sent += static_cast<std::size_t>(n);
+                pending -= static_cast<std::size_t>(n);
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                return false;
+            }
+        }
+        if (pending == 0) {
+            connection.outbound.clear();
+            connection.sent = 0;
+        } else if (pending > maxOutbound) {
+            return false;
+        } else if (connection.sent > connection.outbound.size() / 2) {
+            connection.outbound.erase(connection.outbound.begin(), connection.outbound.begin() + connection.sent);
+            connection.sent = 0;
+        }
+        bool waiting = pending > 0;
+        if (waiting != connection.waitingForOutput) {
+            watch(connection.fd, waiting ? EPOLLIN | EPOLLOUT : EPOLLIN, EPOLL_CTL_MOD);
+            connection.waitingForOutput = waiting;
+        }
+        return true;
+    }
+
+    void close(int fd) {
+        auto it = connections.find(fd);
+        if (it == connections.end()) return;
+        protocol.disconnect(fd);
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(it);
+    }
+
+    int epollFd;
+    std::vector<int> listeners;
+    std::vector<std::string> unixPaths;
+    std::unordered_map<int, std::unique_ptr<Connection>> connections;
+    std::vector<int> dirty; // Connections with output this pass
+    Protocol protocol;
+    uint64_t calls = 0;
+};
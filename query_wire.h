@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "order_wire.h"
+
+// Binary price query protocol between external clients and main's query server
+// Same framing as the order protocol (order_wire.h): fixed size little endian messages that
+// start with a WireHeader, fixed point prices, so clients reuse WireReader and makeWireMessage
+// A client resolves names to symbol ids once with QueryLookup, then asks for the latest price of
+// up to queryMaxGet symbols per QueryGet, or subscribes to be pushed every new price
+// requestId is chosen by the client and echoed back, pushed prices carry requestId 0
+
+constexpr const char *defaultQueryAddress = "/tmp/lowlatency-query.sock";
+constexpr std::size_t querySymbolLength = 16;
+constexpr std::size_t queryMaxGet = 13;
+
+enum QueryMessageType : uint8_t {
+    QueryLookupType = 32,
+    QuerySymbolInfoType = 33,
+    QueryGetType = 34,
+    QuerySubscribeType = 35,
+    QueryPriceType = 36,
+};
+
+enum QueryStatus : uint8_t {
+    QueryOk = 0,
+    QueryUnknownSymbol = 1,
+    QueryNoPrice = 2, // Listed but never updated
+};
+
+struct QueryLookup {
+    WireHeader header;
+    uint32_t requestId;
+    char name[querySymbolLength]; // Zero padded
+};
+static_assert(sizeof(QueryLookup) == 24, "wire layout");
+
+// symbol is invalidSymbol (all ones) when the name isn't listed
+struct QuerySymbolInfo {
+    WireHeader header;
+    uint32_t requestId;
+    uint32_t symbol;
+    uint32_t reserved;
+    char name[querySymbolLength];
+};
+static_assert(sizeof(QuerySymbolInfo) == 32, "wire layout");
+
+// Answered with one QueryPrice per symbol, in order, all in the same write
+struct QueryGet {
+    WireHeader header;
+    uint32_t requestId;
+    uint32_t count;
+    uint32_t symbols[queryMaxGet];
+};
+static_assert(sizeof(QueryGet) == 64, "wire layout");
+
+// subscribe 1 starts pushes for symbol, 0 stops them; answered with the current price
+struct QuerySubscribe {
+    WireHeader header;
+    uint32_t requestId;
+    uint32_t symbol;
+    uint8_t subscribe;
+    uint8_t reserved[3];
+};
+static_assert(sizeof(QuerySubscribe) == 16, "wire layout");
+
+struct QueryPrice {
+    WireHeader header;
+    uint32_t requestId;
+    uint32_t symbol;
+    uint8_t status;
+    uint8_t reserved[3];
+    int64_t price;
+    int64_t timestamp; // Time of the update, nanoseconds since epoch
+    uint64_t seq;      // Per symbol update count, gaps mean conflated updates
+};
+static_assert(sizeof(QueryPrice) == 40, "wire layout");
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tick_store.h"
+
+// Deterministic replay of a recorded tick store on one thread
+// The ticks of every symbol are merged by timestamp, ties go to the symbol listed first, and
+// timers fire on multiples of their interval in recorded time, before any tick at or after the
+// deadline; nothing reads the wall clock, so the same store and range always produce the same
+// sequence of calls
+
+class TickReplay {
+public:
+    TickReplay(TickStoreReader &reader, const std::vector<std::string> &symbols, int64_t from, int64_t to)
+        : from(from), to(to) {
+        for (const auto &symbol : symbols) {
+            Stream stream;
+            std::size_t count;
+            const TickBlockIndex *first = reader.blockIndex(symbol, count);
+            stream.data = reader.blockData(symbol);
+            stream.block = std::lower_bound(first, first + count, from,
+                [](const TickBlockIndex &entry, int64_t t) { return entry.lastTimestamp < t; });
+            stream.last = first + count;
+            streams.push_back(std::move(stream));
+        }
+    }
+
+    // Simulated clock, the timestamp of the event being delivered
+    int64_t now() const { return clock; }
+
+    // onTick(size_t stream, const Tick &) for every tick, stream is the index into symbols
+    // onTimer(int64_t deadline) every timerInterval, returns the number of ticks delivered
+    template <typename OnTick, typename OnTimer>
+    uint64_t run(int64_t timerInterval, OnTick &&onTick, OnTimer &&onTimer) {
+        using Head = std::pair<int64_t, std::size_t>; // Timestamp, stream
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        for (std::size_t i = 0; i < streams.size(); ++i) {
+            if (advance(streams[i])) heads.emplace(streams[i].current().timestamp, i);
+        }
+
+        uint64_t delivered = 0;
+        int64_t nextTimer = heads.empty() ? 0 : heads.top().first - heads.top().first % timerInterval + timerInterval;
+        while (!heads.empty()) {
+            auto [timestamp, index] = heads.top();
+            heads.pop();
+            while (nextTimer <= timestamp) {
+                clock = nextTimer;
+                onTimer(nextTimer);
+                nextTimer += timerInterval;
+            }
+
+            Stream &stream = streams[index];
+            clock = timestamp;
+            onTick(index, stream.current());
+            ++delivered;
+            ++stream.position;
+            if (advance(stream)) heads.emplace(stream.current().timestamp, index);
+        }
+        // Close out the last interval
+        clock = nextTimer;
+        onTimer(nextTimer);
+        return delivered;
+    }
+
+private:
+    struct Stream {
+        const uint8_t *data = nullptr;
+        const TickBlockIndex *block = nullptr;
+        const TickBlockIndex *last = nullptr;
+        std::vector<int64_t> timestamps = std::vector<int64_t>(ticksPerBlock);
+        std::vector<double> prices = std::vector<double>(ticksPerBlock);
+        std::size_t position = 0;
+        std::size_t end = 0;
+
+        Tick current() const { return Tick{timestamps[position], prices[position]}; }
+    };
+
+    // Makes the stream's current tick valid, decoding the next block when needed, false at the end
+    bool advance(Stream &stream) {
+        while (stream.position == stream.end) {
+            if (stream.block == stream.last || stream.block->firstTimestamp > to) return false;
+            decodeTickBlock(*stream.block, stream.data, stream.timestamps.data(), stream.prices.data());
+            stream.position = 0;
+            stream.end = stream.block->count;
+            if (stream.block->firstTimestamp < from) {
+                stream.position = std::lower_bound(stream.timestamps.begin(), stream.timestamps.begin() + stream.end, from) -
+                                  stream.timestamps.begin();
+            }
+            if (stream.block->lastTimestamp > to) {
+                stream.end = std::upper_bound(stream.timestamps.begin() + stream.position,
+                                              stream.timestamps.begin() + stream.end, to) - stream.timestamps.begin();
+            }
+            ++stream.block;
+        }
+        return true;
+    }
+
+    int64_t from;
+    int64_t to;
+    int64_t clock = 0;
+    std::vector<Stream> streams;
+};
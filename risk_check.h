@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "symbols.h"
+
+// Pre trade risk checks for a proposed order against the last traded price
+// All limits and running state live in flat arrays sized at construction,
+// (account, symbol) state is one cache line at account * symbolCount + symbol
+// check() evaluates every rule without early exits or allocation and returns a bit mask of
+// the rules that failed; an order that passes is booked into position, credit and throttle
+
+enum RiskReject : uint32_t {
+    RiskPriceCollar = 1u << 0,    // Limit price too far from the last price, or no last price yet
+    RiskMaxNotional = 1u << 1,    // Order notional above the per order limit
+    RiskPositionLimit = 1u << 2,  // Position including open orders would exceed the limit
+    RiskCreditLimit = 1u << 3,    // Account's open notional would exceed its credit
+    RiskThrottle = 1u << 4,       // Account sent too many orders in the last second
+    RiskUnknownAccount = 1u << 5, // Account or symbol id out of range
+};
+
+struct Order {
+    uint64_t orderId;
+    uint32_t account;
+    SymbolId symbol;
+    int32_t side;      // +1 buy, -1 sell
+    int64_t quantity;
+    double price;
+    int64_t timestamp; // nanoseconds, drives the throttle
+};
+
+struct SymbolRiskLimits {
+    double collar = 0.05;          // Allowed distance from the last price as a fraction of it
+    double maxNotional = 1e6;
+    int64_t maxPosition = 10000;   // Absolute shares, long or short
+};
+
+struct AccountRiskLimits {
+    double creditLimit = 1e7;      // Open notional the account may have outstanding
+    double ordersPerSecond = 1000; // Sustained rate
+    double burst = 100;            // Orders that can go out back to back
+};
+
+class RiskEngine {
+public:
+    RiskEngine(uint32_t accountCount, uint32_t symbolCount)
+        : accountCount(accountCount), symbolCount(symbolCount),
+          slots(static_cast<std::size_t>(accountCount) * symbolCount), accounts(accountCount) {}
+
+    void setSymbolLimits(uint32_t account, SymbolId symbol, const SymbolRiskLimits &limits) {
+        slots[index(account, symbol)].limits = limits;
+    }
+
+    void setAccountLimits(uint32_t account, const AccountRiskLimits &limits) {
+        accounts[account].limits = limits;
+        accounts[account].tokens = limits.burst;
+    }
+
+    // 0 when the order passes, otherwise RiskReject bits; lastPrice <= 0 means no price yet
+    uint32_t check(const Order &order, double lastPrice) {
+        if (order.account >= accountCount || order.symbol >= symbolCount) return RiskUnknownAccount;
+        SymbolSlot &slot = slots[index(order.account, order.symbol)];
+        AccountSlot &account = accounts[order.account];
+
+        double notional = order.price * static_cast<double>(order.quantity);
+        int64_t signedQuantity = order.side * order.quantity;
+        int64_t position = slot.position + signedQuantity;
+        int64_t elapsed = std::max<int64_t>(order.timestamp - account.lastRefill, 0);
+        double tokens = std::min(account.limits.burst,
+                                 account.tokens + static_cast<double>(elapsed) * account.limits.ordersPerSecond * 1e-9);
+
+        uint32_t reasons = 0;
+        // Written so a NaN or missing last price fails the collar
+        reasons |= static_cast<uint32_t>(!(std::fabs(order.price - lastPrice) <= slot.limits.collar * lastPrice) | !(lastPrice > 0.0)) * RiskPriceCollar;
+        reasons |= static_cast<uint32_t>(!(notional <= slot.limits.maxNotional) | (order.quantity <= 0)) * RiskMaxNotional;
+        reasons |= static_cast<uint32_t>((position > slot.limits.maxPosition) | (position < -slot.limits.maxPosition)) * RiskPositionLimit;
+        reasons |= static_cast<uint32_t>(!(account.openNotional + notional <= account.limits.creditLimit)) * RiskCreditLimit;
+        reasons |= static_cast<uint32_t>(tokens < 1.0) * RiskThrottle;
+
+        // Book the order only when everything passed, without branching on it
+        int64_t accepted = reasons == 0;
+        slot.position += accepted * signedQuantity;
+        account.openNotional += static_cast<double>(accepted) * notional;
+        account.tokens = tokens - static_cast<double>(accepted);
+        account.lastRefill = std::max(account.lastRefill, order.timestamp);
+        return reasons;
+    }
+
+    // Part of an accepted order was cancelled or rejected downstream, undo its booking
+    void onCancel(const Order &order, int64_t cancelledQuantity) {
+        slots[index(order.account, order.symbol)].position -= order.side * cancelledQuantity;
+        accounts[order.account].openNotional -= order.price * static_cast<double>(cancelledQuantity);
+    }
+
+    // Part of an accepted order traded, its position stays and its credit is released
+    void onFill(const Order &order, int64_t filledQuantity) {
+        accounts[order.account].openNotional -= order.price * static_cast<double>(filledQuantity);
+    }
+
+    int64_t position(uint32_t account, SymbolId symbol) const { return slots[index(account, symbol)].position; }
+    double openNotional(uint32_t account) const { return accounts[account].openNotional; }
+
+private:
+    struct alignas(64) SymbolSlot {
+        SymbolRiskLimits limits;
+        int64_t position = 0;
+    };
+
+    struct alignas(64) AccountSlot {
+        AccountRiskLimits limits;
+        double openNotional = 0.0;
+        double tokens = AccountRiskLimits().burst; // Throttle token bucket
+        int64_t lastRefill = 0;
+    };
+
+    std::size_t index(uint32_t account, SymbolId symbol) const {
+        return static_cast<std::size_t>(account) * symbolCount + symbol;
+    }
+
+    uint32_t accountCount;
+    uint32_t symbolCount;
+    std::vector<SymbolSlot> slots;
+    std::vector<AccountSlot> accounts;
+};
+
+// Short name of the first failed rule, for logs
+inline const char *riskRejectName(uint32_t reasons) {
+    if (reasons & RiskUnknownAccount) return "unknown account";
+    if (reasons & RiskPriceCollar) return "price collar";
+    if (reasons & RiskMaxNotional) return "max notional";
+    if (reasons & RiskPositionLimit) return "position limit";
+    if (reasons & RiskCreditLimit) return "credit limit";
+    if (reasons & RiskThrottle) return "throttle";
+    return "accepted";
+}
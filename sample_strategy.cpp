@@ -0,0 +1,103 @@
+// Example strategy plugin, loaded with main --strategy ./sample_strategy.so
+// Build: g++ -std=c++17 -O2 -shared -fPIC sample_strategy.cpp -o sample_strategy.so
+// Rebuild and send the process SIGHUP to swap it in while running, the moving averages carry over
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "strategy_abi.h"
+
+namespace {
+
+// Fades moves away from an exponential moving average of each symbol's price
+struct MeanReversion {
+    static constexpr uint32_t stateVersion = 1;
+    static constexpr double alpha = 0.05;     // Weight of the newest price in the average
+    static constexpr double threshold = 0.002; // Relative distance from the average that trades
+
+    struct SymbolState {
+        double average;
+        uint64_t ticks;
+    };
+
+    StrategyHost host;
+    std::vector<SymbolState> symbols;
+    int64_t position = 0;
+
+    void onTick(const TickEvent &tick) {
+        if (tick.symbol >= symbols.size()) symbols.resize(tick.symbol + 1, SymbolState{0, 0});
+        SymbolState &state = symbols[tick.symbol];
+        state.average = state.ticks == 0 ? tick.price : state.average + alpha * (tick.price - state.average);
+        ++state.ticks;
+        if (state.ticks < 20) return; // Let the average warm up
+
+        double distance = (tick.price - state.average) / state.average;
+        if (std::fabs(distance) < threshold) return;
+        PluginOrder order{tick.symbol, distance > 0 ? -1 : 1, 10, tick.price, 1, {}};
+        host.sendOrder(host.context, &order, tick.timestamp);
+    }
+
+    void onFill(const FillEvent &fill) { position += fill.side * fill.quantity; }
+
+    // Layout: version, position, symbol count, then the per symbol state
+    std::size_t exportState(void *buffer, std::size_t capacity) const {
+        std::size_t needed = sizeof(uint32_t) + sizeof(int64_t) + sizeof(uint64_t) + symbols.size() * sizeof(SymbolState);
+        if (capacity < needed) return needed;
+        char *out = static_cast<char *>(buffer);
+        uint64_t count = symbols.size();
+        std::memcpy(out, &stateVersion, sizeof(stateVersion));
+        std::memcpy(out + 4, &position, sizeof(position));
+        std::memcpy(out + 12, &count, sizeof(count));
+        if (count) std::memcpy(out + 20, symbols.data(), count * sizeof(SymbolState));
+        return needed;
+    }
+
+    // Accepts nothing (first load) or a state of a version it knows
+    bool importState(const void *buffer, std::size_t size) {
+        if (!buffer) return true;
+        const char *in = static_cast<const char *>(buffer);
+        uint32_t version;
+        uint64_t count;
+        if (size < 20) return false;
+        std::memcpy(&version, in, sizeof(version));
+        std::memcpy(&position, in + 4, sizeof(position));
+        std::memcpy(&count, in + 12, sizeof(count));
+        if (version != stateVersion || size != 20 + count * sizeof(SymbolState)) return false;
+        symbols.resize(count);
+        if (count) std::memcpy(symbols.data(), in + 20, count * sizeof(SymbolState));
+        return true;
+    }
+};
+
+void *create(const StrategyHost *host, const void *state, std::size_t stateSize) {
+    auto *strategy = new MeanReversion{*host, {}, 0};
+    if (!strategy->importState(state, stateSize)) {
+        delete strategy;
+        return nullptr;
+    }
+    std::string message = "mean reversion tracking " + std::to_string(strategy->symbols.size()) + " symbols";
+    host->log(host->context, message.c_str());
+    return strategy;
+}
+
+void destroy(void *instance) { delete static_cast<MeanReversion *>(instance); }
+
+void onTick(void *instance, const TickEvent *tick) { static_cast<MeanReversion *>(instance)->onTick(*tick); }
+
+void onBar(void *, const Bar *) {}
+
+void onFill(void *instance, const FillEvent *fill) { static_cast<MeanReversion *>(instance)->onFill(*fill); }
+
+std::size_t exportState(void *instance, void *buffer, std::size_t capacity) {
+    return static_cast<MeanReversion *>(instance)->exportState(buffer, capacity);
+}
+
+const StrategyPluginApi api{
+    strategyAbiVersion, sizeof(StrategyPluginApi), "mean reversion", create, destroy, onTick, onBar, onFill, exportState,
+};
+
+} // namespace
+
+extern "C" const StrategyPluginApi *lowlatencyStrategyPlugin() { return &api; }
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <immintrin.h>
+
+#include "cpu_dispatch.h"
+
+// Decode and scan kernels for the tick store blocks
+// Every kernel has a scalar version plus AVX2 and AVX-512 versions where they pay off,
+// scanKernels() picks one set at startup through cpu_dispatch.h
+
+inline uint64_t zigzagEncode(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+inline int64_t zigzagDecode(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+// Bytes a packed column of n values of the given width occupies, rounded up to whole
+// words plus one spare word so decoders can always do unaligned 8 byte loads
+inline std::size_t packedBytes(std::size_t n, unsigned bits) {
+    return ((n * bits + 63) / 64 + 1) * 8;
+}
+
+// Value i of a column packed LSB first, it occupies bits [i * bits, (i + 1) * bits)
+inline uint64_t unpackOne(const uint8_t *in, std::size_t i, unsigned bits, uint64_t mask) {
+    std::size_t bit = i * bits;
+    unsigned shift = bit & 63;
+    uint64_t lo, hi;
+    std::memcpy(&lo, in + (bit >> 6) * 8, 8);
+    uint64_t v = lo >> shift;
+    if (shift + bits > 64) {
+        std::memcpy(&hi, in + (bit >> 6) * 8 + 8, 8);
+        v |= hi << (64 - shift);
+    }
+    return v & mask;
+}
+
+inline uint64_t packedMask(unsigned bits) {
+    return bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+}
+
+inline void unpackBitsScalar(const uint8_t *in, std::size_t n, unsigned bits, uint64_t *out) {
+    if (bits == 0) {
+        std::fill(out, out + n, 0);
+        return;
+    }
+    const uint64_t mask = packedMask(bits);
+    for (std::size_t i = 0; i < n; ++i) out[i] = unpackOne(in, i, bits, mask);
+}
+
+// Turn an unpacked zigzag delta of delta column back into timestamps
+// column[0] and column[1] are zero, the first delta is carried separately
+inline void decodeTimestampsScalar(int64_t firstTimestamp, int64_t firstDelta, std::size_t n, const uint64_t *column, int64_t *out) {
+    int64_t delta = 0, ts = firstTimestamp;
+    for (std::size_t i = 0; i < n; ++i) {
+        delta += zigzagDecode(column[i]) + (i == 1 ? firstDelta : 0);
+        ts += delta;
+        out[i] = ts;
+    }
+}
+
+// Copy the ticks with tLo <= timestamp <= tHi and pLo <= price <= pHi to the front of outTimestamps
+// and outPrices, returns how many were kept; the outputs may alias the inputs
+inline std::size_t filterTicksScalar(const int64_t *timestamps, const double *prices, std::size_t n,
+                                     int64_t tLo, int64_t tHi, double pLo, double pHi,
+                                     int64_t *outTimestamps, double *outPrices) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        int64_t ts = timestamps[i];
+        double px = prices[i];
+        outTimestamps[count] = ts;
+        outPrices[count] = px;
+        count += (ts >= tLo) & (ts <= tHi) & (px >= pLo) & (px <= pHi);
+    }
+    return count;
+}
+
+__attribute__((target("avx2")))
+inline void unpackBitsAvx2(const uint8_t *in, std::size_t n, unsigned bits, uint64_t *out) {
+    // A gathered 8 byte word holds the whole value as long as shift (< 8) + bits <= 64
+    if (bits == 0 || bits > 56) {
+        unpackBitsScalar(in, n, bits, out);
+        return;
+    }
+    const uint64_t mask = packedMask(bits);
+    const __m256i maskVec = _mm256_set1_epi64x(static_cast<long long>(mask));
+    const __m256i seven = _mm256_set1_epi64x(7);
+    const __m256i step = _mm256_set1_epi64x(static_cast<long long>(4 * bits));
+    __m256i bitOffsets = _mm256_set_epi64x(3 * bits, 2 * bits, bits, 0);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i byteOffsets = _mm256_srli_epi64(bitOffsets, 3);
+        __m256i words = _mm256_i64gather_epi64(reinterpret_cast<const long long *>(in), byteOffsets, 1);
+        __m256i values = _mm256_srlv_epi64(words, _mm256_and_si256(bitOffsets, seven));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), _mm256_and_si256(values, maskVec));
+        bitOffsets = _mm256_add_epi64(bitOffsets, step);
+    }
+    for (; i < n; ++i) out[i] = unpackOne(in, i, bits, mask);
+}
+
+// GCC 12 flags the deliberately undefined source operand inside its own AVX-512 intrinsics
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+inline void unpackBitsAvx512(const uint8_t *in, std::size_t n, unsigned bits, uint64_t *out) {
+    if (bits == 0 || bits > 56) {
+        unpackBitsScalar(in, n, bits, out);
+        return;
+    }
+    const uint64_t mask = packedMask(bits);
+    const __m512i maskVec = _mm512_set1_epi64(static_cast<long long>(mask));
+    const __m512i seven = _mm512_set1_epi64(7);
+    const __m512i step = _mm512_set1_epi64(static_cast<long long>(8 * bits));
+    __m512i bitOffsets = _mm512_set_epi64(7 * bits, 6 * bits, 5 * bits, 4 * bits, 3 * bits, 2 * bits, bits, 0);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i words = _mm512_i64gather_epi64(_mm512_srli_epi64(bitOffsets, 3), in, 1);
+        __m512i values = _mm512_srlv_epi64(words, _mm512_and_si512(bitOffsets, seven));
+        _mm512_storeu_si512(out + i, _mm512_and_si512(values, maskVec));
+        bitOffsets = _mm512_add_epi64(bitOffsets, step);
+    }
+    for (; i < n; ++i) out[i] = unpackOne(in, i, bits, mask);
+}
+#pragma GCC diagnostic pop
+
+// Inclusive prefix sum of four int64 lanes
+__attribute__((target("avx2")))
+inline __m256i prefixSum4(__m256i x) {
+    const __m256i zero = _mm256_setzero_si256();
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(2, 1, 0, 0)), zero, 0x03));
+    x = _mm256_add_epi64(x, _mm256_blend_epi32(_mm256_permute4x64_epi64(x, _MM_SHUFFLE(1, 0, 0, 0)), zero, 0x0F));
+    return x;
+}
+
+__attribute__((target("avx2")))
+inline void decodeTimestampsAvx2(int64_t firstTimestamp, int64_t firstDelta, std::size_t n, const uint64_t *column, int64_t *out) {
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i carryDelta = zero;
+    __m256i carryTs = _mm256_set1_epi64x(firstTimestamp);
+    __m256i patch = _mm256_set_epi64x(0, 0, firstDelta, 0); // first delta goes into lane 1 of the first group
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+        // zigzag decode: (v >> 1) ^ -(v & 1)
+        __m256i d = _mm256_xor_si256(_mm256_srli_epi64(v, 1), _mm256_sub_epi64(zero, _mm256_and_si256(v, one)));
+        d = _mm256_add_epi64(d, patch);
+        patch = zero;
+        __m256i delta = _mm256_add_epi64(prefixSum4(d), carryDelta);
+        __m256i ts = _mm256_add_epi64(prefixSum4(delta), carryTs);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), ts);
+        carryDelta = _mm256_permute4x64_epi64(delta, _MM_SHUFFLE(3, 3, 3, 3));
+        carryTs = _mm256_permute4x64_epi64(ts, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    if (i == n) return;
+
+    // Scalar tail picks up from the last full group, i >= 4 here
+    int64_t delta = i == 0 ? 0 : out[i - 1] - out[i - 2];
+    int64_t ts = i == 0 ? firstTimestamp : out[i - 1];
+    for (; i < n; ++i) {
+        delta += zigzagDecode(column[i]) + (i == 1 ? firstDelta : 0);
+        ts += delta;
+        out[i] = ts;
+    }
+}
+
+// permutevar8x32 indices that move the 64 bit lanes selected by a 4 bit mask to the front
+struct CompressTable {
+    alignas(32) int32_t indices[16][8];
+
+    constexpr CompressTable() : indices() {
+        for (int mask = 0; mask < 16; ++mask) {
+            int out = 0;
+            for (int lane = 0; lane < 4; ++lane) {
+                if (mask & (1 << lane)) {
+                    indices[mask][2 * out] = 2 * lane;
+                    indices[mask][2 * out + 1] = 2 * lane + 1;
+                    ++out;
+                }
+            }
+        }
+    }
+};
+
+inline constexpr CompressTable compressTable{};
+
+__attribute__((target("avx2")))
+inline std::size_t filterTicksAvx2(const int64_t *timestamps, const double *prices, std::size_t n,
+                                   int64_t tLo, int64_t tHi, double pLo, double pHi,
+                                   int64_t *outTimestamps, double *outPrices) {
+    const __m256i tLoVec = _mm256_set1_epi64x(tLo), tHiVec = _mm256_set1_epi64x(tHi);
+    const __m256d pLoVec = _mm256_set1_pd(pLo), pHiVec = _mm256_set1_pd(pHi);
+
+    std::size_t count = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i ts = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(timestamps + i));
+        __m256d px = _mm256_loadu_pd(prices + i);
+        // outside = ts < tLo or ts > tHi
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi64(tLoVec, ts), _mm256_cmpgt_epi64(ts, tHiVec));
+        __m256d inPrice = _mm256_and_pd(_mm256_cmp_pd(px, pLoVec, _CMP_GE_OQ), _mm256_cmp_pd(px, pHiVec, _CMP_LE_OQ));
+        __m256d keep = _mm256_andnot_pd(_mm256_castsi256_pd(outside), inPrice);
+        int mask = _mm256_movemask_pd(keep);
+
+        __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i *>(compressTable.indices[mask]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(outTimestamps + count), _mm256_permutevar8x32_epi32(ts, perm));
+        _mm256_storeu_pd(outPrices + count, _mm256_castsi256_pd(_mm256_permutevar8x32_epi32(_mm256_castpd_si256(px), perm)));
+        count += static_cast<std::size_t>(__builtin_popcount(mask));
+    }
+    return count + filterTicksScalar(timestamps + i, prices + i, n - i, tLo, tHi, pLo, pHi,
+                                     outTimestamps + count, outPrices + count);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+inline std::size_t filterTicksAvx512(const int64_t *timestamps, const double *prices, std::size_t n,
+                                     int64_t tLo, int64_t tHi, double pLo, double pHi,
+                                     int64_t *outTimestamps, double *outPrices) {
+    const __m512i tLoVec = _mm512_set1_epi64(tLo), tHiVec = _mm512_set1_epi64(tHi);
+    const __m512d pLoVec = _mm512_set1_pd(pLo), pHiVec = _mm512_set1_pd(pHi);
+
+    std::size_t count = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i ts = _mm512_loadu_si512(timestamps + i);
+        __m512d px = _mm512_loadu_pd(prices + i);
+        __mmask8 keep = _mm512_cmp_epi64_mask(ts, tLoVec, _MM_CMPINT_NLT);
+        keep = _mm512_mask_cmp_epi64_mask(keep, ts, tHiVec, _MM_CMPINT_LE);
+        keep = _mm512_mask_cmp_pd_mask(keep, px, pLoVec, _CMP_GE_OQ);
+        keep = _mm512_mask_cmp_pd_mask(keep, px, pHiVec, _CMP_LE_OQ);
+        _mm512_mask_compressstoreu_epi64(outTimestamps + count, keep, ts);
+        _mm512_mask_compressstoreu_pd(outPrices + count, keep, px);
+        count += static_cast<std::size_t>(__builtin_popcount(keep));
+    }
+    return count + filterTicksScalar(timestamps + i, prices + i, n - i, tLo, tHi, pLo, pHi,
+                                     outTimestamps + count, outPrices + count);
+}
+
+// One implementation of every kernel, chosen once from what the CPU supports
+struct ScanKernels {
+    void (*unpackBits)(const uint8_t *, std::size_t, unsigned, uint64_t *);
+    void (*decodeTimestamps)(int64_t, int64_t, std::size_t, const uint64_t *, int64_t *);
+    std::size_t (*filterTicks)(const int64_t *, const double *, std::size_t, int64_t, int64_t, double, double, int64_t *, double *);
+};
+
+inline const ScanKernels &scanKernels() {
+    static const ScanKernels kernels{
+        selectKernel(unpackBitsScalar, nullptr, unpackBitsAvx2, unpackBitsAvx512),
+        selectKernel(decodeTimestampsScalar, nullptr, decodeTimestampsAvx2, nullptr),
+        selectKernel(filterTicksScalar, nullptr, filterTicksAvx2, filterTicksAvx512),
+    };
+    return kernels;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Small helpers shared by the gateway, the exchange and the client servers
+// An address is either "host:port" for TCP or a filesystem path for a Unix stream socket
+
+inline bool isTcpAddress(const std::string &address) {
+    return !address.empty() && address[0] != '/' && address[0] != '.' && address.find(':') != std::string::npos;
+}
+
+inline void setNonBlocking(int fd) {
+    int flags = ::fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw std::runtime_error(std::string("fcntl O_NONBLOCK: ") + std::strerror(errno));
+    }
+}
+
+// Disable Nagle on TCP sockets, a no-op on Unix sockets
+inline void setNoDelay(int fd) {
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+inline sockaddr_un unixAddress(const std::string &path) {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("unix socket path too long: " + path);
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+inline addrinfo *resolveTcp(const std::string &address, bool passive) {
+    std::size_t colon = address.rfind(':');
+    std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = passive ? AI_PASSIVE : 0;
+    addrinfo *result = nullptr;
+    int rc = ::getaddrinfo(host.empty() || host == "*" ? nullptr : host.c_str(), port.c_str(), &hints, &result);
+    if (rc != 0) throw std::runtime_error("cannot resolve " + address + ": " + ::gai_strerror(rc));
+    return result;
+}
+
+// Listening socket for address, an existing Unix socket file is replaced
+inline int listenOn(const std::string &address, int backlog = 1024) {
+    int fd;
+    if (isTcpAddress(address)) {
+        addrinfo *info = resolveTcp(address, true);
+        fd = ::socket(info->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        int rc = fd < 0 ? -1 : ::bind(fd, info->ai_addr, info->ai_addrlen);
+        ::freeaddrinfo(info);
+        if (rc != 0) {
+            if (fd >= 0) ::close(fd);
+            throw std::runtime_error("cannot bind " + address + ": " + std::strerror(errno));
+        }
+    } else {
+        sockaddr_un addr = unixAddress(address);
+        ::unlink(address.c_str());
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+            if (fd >= 0) ::close(fd);
+            throw std::runtime_error("cannot bind " + address + ": " + std::strerror(errno));
+        }
+    }
+    if (::listen(fd, backlog) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot listen on " + address + ": " + std::strerror(errno));
+    }
+    return fd;
+}
+
+// Blocking connect, the caller switches the socket to non blocking if it wants to
+inline int connectTo(const std::string &address) {
+    int fd = -1;
+    if (isTcpAddress(address)) {
+        addrinfo *info = resolveTcp(address, false);
+        for (addrinfo *ai = info; ai; ai = ai->ai_next) {
+            fd = ::socket(ai->ai_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (fd >= 0 && ::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) break;
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+        ::freeaddrinfo(info);
+        if (fd >= 0) setNoDelay(fd);
+    } else {
+        sockaddr_un addr = unixAddress(address);
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (fd < 0) throw std::runtime_error("cannot connect to " + address + ": " + std::strerror(errno));
+    return fd;
+}
+
+// Write all of buffer, waiting out EAGAIN on non blocking sockets; false once the peer is gone
+inline bool writeAll(int fd, const void *buffer, std::size_t length) {
+    const char *p = static_cast<const char *>(buffer);
+    while (length > 0) {
+        ssize_t n = ::send(fd, p, length, MSG_NOSIGNAL);
+        if (n > 0) {
+            p += n;
+            length -= static_cast<std::size_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+            continue;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded single producer single consumer ring
+// Each side keeps a cached copy of the other side's index and only reloads the shared one
+// when the cache says the ring is full (producer) or empty (consumer)
+template <typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    // Producer side
+    bool tryPush(const T &value) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) return false;
+        }
+        slots[t & (Capacity - 1)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool tryPop(T &value) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        value = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate, exact only when called from one of the two sides while the other is idle
+    std::size_t size() const {
+        return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<std::size_t> head{0}; // Next slot to pop, written by the consumer
+    std::size_t cachedTail = 0;                    // Consumer's copy of tail
+    alignas(64) std::atomic<std::size_t> tail{0}; // Next slot to push, written by the producer
+    std::size_t cachedHead = 0;                    // Producer's copy of head
+    alignas(64) T slots[Capacity];
+};
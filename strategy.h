@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "symbols.h"
+
+// Strategy plug-in interface without virtual calls
+// A strategy derives from Strategy<Self> and hides the handlers it cares about:
+//     struct Momentum : Strategy<Momentum> { void onTick(const TickEvent &tick) { ... } };
+// StrategyEngine<Momentum, Other...> owns one instance of each, knows their concrete types and
+// calls the handlers directly, so the compiler can inline them into the loop that applies updates
+// Strategies are registered per symbol, a symbol's subscribers are a bit mask over the type list
+
+struct TickEvent {
+    SymbolId symbol;
+    double price;
+    int64_t timestamp;
+};
+
+// Time bar built from the ticks, [start, end)
+struct Bar {
+    SymbolId symbol;
+    int64_t start;
+    int64_t end;
+    double open;
+    double high;
+    double low;
+    double close;
+    uint32_t ticks;
+};
+
+// Consolidated best bid and offer across venues (consolidated_quote.h), sent when it changes
+struct QuoteEvent {
+    SymbolId symbol;
+    double bid;      // 0 when no venue bids
+    double ask;      // 0 when no venue offers
+    int64_t bidSize;
+    int64_t askSize;
+    int64_t timestamp;
+};
+
+struct FillEvent {
+    SymbolId symbol;
+    uint64_t orderId;
+    int32_t side;
+    int64_t quantity;
+    double price;
+    int64_t timestamp;
+};
+
+template <typename Self>
+class Strategy {
+public:
+    // Defaults for the events a strategy doesn't handle, they compile away
+    void onTick(const TickEvent &) {}
+    void onBar(const Bar &) {}
+    void onQuote(const QuoteEvent &) {}
+    void onFill(const FillEvent &) {}
+
+protected:
+    Self &self() { return static_cast<Self &>(*this); }
+};
+
+template <typename T, typename... Ts>
+struct TypeIndex;
+
+template <typename T, typename... Ts>
+struct TypeIndex<T, T, Ts...> : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct TypeIndex<T, U, Ts...> : std::integral_constant<std::size_t, 1 + TypeIndex<T, Ts...>::value> {};
+
+template <typename... Strategies>
+class StrategyEngine {
+    static_assert(sizeof...(Strategies) <= 64, "subscriber masks are 64 bit");
+
+public:
+    explicit StrategyEngine(int64_t barInterval = 1000000000) : barInterval(barInterval) {}
+
+    template <typename S>
+    S &get() { return std::get<S>(strategies); }
+
+    template <typename S>
+    void subscribe(SymbolId symbol) {
+        static_assert(std::is_base_of<Strategy<S>, S>::value, "strategies derive from Strategy<Self>");
+        if (symbol >= subscribers.size()) {
+            subscribers.resize(symbol + 1, 0);
+            bars.resize(symbol + 1);
+        }
+        subscribers[symbol] |= uint64_t(1) << TypeIndex<S, Strategies...>::value;
+    }
+
+    // Feed one price update, closes the symbol's bar first if the tick falls past its end
+    void onTick(const TickEvent &tick) {
+        if (tick.symbol >= subscribers.size() || subscribers[tick.symbol] == 0) return;
+        uint64_t mask = subscribers[tick.symbol];
+
+        Bar &bar = bars[tick.symbol];
+        if (bar.ticks > 0 && tick.timestamp >= bar.end) {
+            dispatchBar(mask, bar, Indices{});
+            bar.ticks = 0;
+        }
+        if (bar.ticks == 0) {
+            int64_t start = tick.timestamp - tick.timestamp % barInterval;
+            bar = Bar{tick.symbol, start, start + barInterval, tick.price, tick.price, tick.price, tick.price, 0};
+        }
+        bar.high = tick.price > bar.high ? tick.price : bar.high;
+        bar.low = tick.price < bar.low ? tick.price : bar.low;
+        bar.close = tick.price;
+        ++bar.ticks;
+
+        dispatchTick(mask, tick, Indices{});
+    }
+
+    // Close every bar that ended at or before now, for symbols that stopped ticking
+    void onTimer(int64_t now) {
+        for (std::size_t symbol = 0; symbol < bars.size(); ++symbol) {
+            Bar &bar = bars[symbol];
+            if (bar.ticks > 0 && bar.end <= now) {
+                dispatchBar(subscribers[symbol], bar, Indices{});
+                bar.ticks = 0;
+            }
+        }
+    }
+
+    void onQuote(const QuoteEvent &quote) {
+        if (quote.symbol >= subscribers.size() || subscribers[quote.symbol] == 0) return;
+        dispatchQuote(subscribers[quote.symbol], quote, Indices{});
+    }
+
+    void onFill(const FillEvent &fill) {
+        if (fill.symbol >= subscribers.size()) return;
+        dispatchFill(subscribers[fill.symbol], fill, Indices{});
+    }
+
+private:
+    using Indices = std::index_sequence_for<Strategies...>;
+
+    template <std::size_t... I>
+    void dispatchTick(uint64_t mask, const TickEvent &tick, std::index_sequence<I...>) {
+        ((mask & (uint64_t(1) << I) ? std::get<I>(strategies).onTick(tick) : void()), ...);
+    }
+
+    template <std::size_t... I>
+    void dispatchBar(uint64_t mask, const Bar &bar, std::index_sequence<I...>) {
+        ((mask & (uint64_t(1) << I) ? std::get<I>(strategies).onBar(bar) : void()), ...);
+    }
+
+    template <std::size_t... I>
+    void dispatchQuote(uint64_t mask, const QuoteEvent &quote, std::index_sequence<I...>) {
+        ((mask & (uint64_t(1) << I) ? std::get<I>(strategies).onQuote(quote) : void()), ...);
+    }
+
+    template <std::size_t... I>
+    void dispatchFill(uint64_t mask, const FillEvent &fill, std::index_sequence<I...>) {
+        ((mask & (uint64_t(1) << I) ? std::get<I>(strategies).onFill(fill) : void()), ...);
+    }
+
+    std::tuple<Strategies...> strategies;
+    int64_t barInterval;
+    std::vector<uint64_t> subscribers; // By symbol id, bit i is the i-th strategy type
+    std::vector<Bar> bars;             // Bar being built per symbol, ticks == 0 when none is open
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "strategy.h"
+
+// Binary interface between the process and strategies built as shared objects
+// A plugin exports one extern "C" function, lowlatencyStrategyPlugin, returning a table of plain
+// function pointers; everything crossing the boundary is a fixed layout struct, never a C++ class,
+// so a plugin only has to be rebuilt when strategyAbiVersion changes
+// Build one with: g++ -std=c++17 -O2 -shared -fPIC my_strategy.cpp -o my_strategy.so
+
+// Bump on any change to the structs below or to the function table
+constexpr uint32_t strategyAbiVersion = 1;
+
+// The events are shared with StrategyEngine, pin their layout
+static_assert(sizeof(TickEvent) == 24, "TickEvent layout is part of the strategy ABI");
+static_assert(sizeof(Bar) == 64, "Bar layout is part of the strategy ABI");
+static_assert(sizeof(FillEvent) == 48, "FillEvent layout is part of the strategy ABI");
+
+struct PluginOrder {
+    SymbolId symbol;
+    int32_t side; // 1 buy, -1 sell
+    int64_t quantity;
+    double price;
+    uint8_t timeInForce; // 0 day, 1 immediate or cancel
+    uint8_t reserved[7];
+};
+
+// What the process offers a plugin, valid for the lifetime of the instance
+struct StrategyHost {
+    void *context;
+    // Returns 0 when the order was queued to the gateway
+    int (*sendOrder)(void *context, const PluginOrder *order, int64_t tickTimestamp);
+    void (*log)(void *context, const char *message);
+};
+
+struct StrategyPluginApi {
+    uint32_t abiVersion; // strategyAbiVersion the plugin was built against
+    uint32_t size;       // sizeof(StrategyPluginApi) in the plugin
+    const char *name;
+    // state is what the instance being replaced exported, null and 0 on a first load
+    // The format is the plugin's own, version it so a new build can tell an old one's state apart
+    // Returns null to refuse, the running instance is then kept
+    void *(*create)(const StrategyHost *host, const void *state, std::size_t stateSize);
+    void (*destroy)(void *instance);
+    void (*onTick)(void *instance, const TickEvent *tick);
+    void (*onBar)(void *instance, const Bar *bar);
+    void (*onFill)(void *instance, const FillEvent *fill);
+    // Writes the state into buffer when capacity is enough, returns the size it needs either way
+    std::size_t (*exportState)(void *instance, void *buffer, std::size_t capacity);
+};
+
+constexpr const char *strategyPluginEntry = "lowlatencyStrategyPlugin";
+
+extern "C" {
+typedef const StrategyPluginApi *(*StrategyPluginEntry)();
+}
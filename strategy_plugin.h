@@ -0,0 +1,148 @@
+#pragma once
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "strategy_abi.h"
+
+// Strategy slot backed by a shared object that can be replaced while the process runs
+// requestReload() only raises a flag (it is safe from a signal handler), the thread that feeds
+// the strategies performs the swap in onBatchEnd(), between two batches of updates:
+// the new library is loaded and checked, the running instance exports its state, the new one is
+// created from it and only then the old one is destroyed and unloaded
+// A failed load or a refused state keeps the running instance
+
+class PluginStrategy : public Strategy<PluginStrategy> {
+public:
+    PluginStrategy() = default;
+
+    ~PluginStrategy() { unload(current); }
+
+    PluginStrategy(const PluginStrategy&) = delete;
+    PluginStrategy& operator=(const PluginStrategy&) = delete;
+
+    void setHost(const StrategyHost &newHost) { host = newHost; }
+
+    // Load the library at path, replacing the running one, throws if it can't be used
+    void load(const std::string &newPath) {
+        Loaded next = open(newPath);
+
+        std::vector<char> state;
+        if (current.instance) {
+            state.resize(current.api->exportState(current.instance, nullptr, 0));
+            state.resize(current.api->exportState(current.instance, state.data(), state.size()));
+        }
+        next.instance = next.api->create(&host, state.empty() ? nullptr : state.data(), state.size());
+        if (!next.instance) {
+            unload(next);
+            throw std::runtime_error("Strategy " + newPath + " refused the state handed over");
+        }
+
+        unload(current);
+        current = next;
+        path = newPath;
+        std::cout << "Strategy loaded: " << current.api->name << " from " << path << " with "
+                  << state.size() << " bytes of state" << std::endl;
+    }
+
+    bool loaded() const { return current.instance != nullptr; }
+
+    // Reload from the same path at the next batch boundary, redeploy by replacing the file
+    void requestReload() { reloadRequested.store(true, std::memory_order_release); }
+
+    void onBatchEnd() {
+        if (!reloadRequested.load(std::memory_order_relaxed)) return;
+        reloadRequested.store(false, std::memory_order_relaxed);
+        if (path.empty()) return;
+        try {
+            load(path);
+        } catch (const std::runtime_error &error) {
+            std::cout << "Strategy reload failed, keeping " << current.api->name << ": " << error.what() << std::endl;
+        }
+    }
+
+    void onTick(const TickEvent &tick) {
+        if (current.instance) current.api->onTick(current.instance, &tick);
+    }
+
+    void onBar(const Bar &bar) {
+        if (current.instance) current.api->onBar(current.instance, &bar);
+    }
+
+    void onFill(const FillEvent &fill) {
+        if (current.instance) current.api->onFill(current.instance, &fill);
+    }
+
+private:
+    struct Loaded {
+        void *handle = nullptr;
+        const StrategyPluginApi *api = nullptr;
+        void *instance = nullptr;
+    };
+
+    // dlopen returns the already loaded handle for a path it has seen, and a library rewritten in
+    // place under a mapping crashes it, so every load goes through a private copy of the file
+    static Loaded open(const std::string &libraryPath) {
+        std::string copyPath = privateCopy(libraryPath);
+        Loaded loaded;
+        loaded.handle = dlopen(copyPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+        ::unlink(copyPath.c_str()); // The mapping stays valid
+        if (!loaded.handle) throw std::runtime_error(std::string("dlopen failed: ") + dlerror());
+
+        auto entry = reinterpret_cast<StrategyPluginEntry>(dlsym(loaded.handle, strategyPluginEntry));
+        loaded.api = entry ? entry() : nullptr;
+        if (!loaded.api || loaded.api->abiVersion != strategyAbiVersion || loaded.api->size < sizeof(StrategyPluginApi)) {
+            dlclose(loaded.handle);
+            throw std::runtime_error(libraryPath + " is not a strategy plugin for ABI version " +
+                                     std::to_string(strategyAbiVersion));
+        }
+        return loaded;
+    }
+
+    static std::string privateCopy(const std::string &libraryPath) {
+        int in = ::open(libraryPath.c_str(), O_RDONLY);
+        if (in < 0) throw std::runtime_error("Failed to open " + libraryPath);
+        char copyPath[] = "/tmp/lowlatency-strategy-XXXXXX";
+        int out = ::mkstemp(copyPath);
+        if (out < 0) {
+            ::close(in);
+            throw std::runtime_error("Failed to create a copy of " + libraryPath);
+        }
+        char buffer[1 << 16];
+        ssize_t n;
+        bool ok = true;
+        while ((n = ::read(in, buffer, sizeof(buffer))) > 0) {
+            if (::write(out, buffer, n) != n) {
+                ok = false;
+                break;
+            }
+        }
+        ok = ok && n == 0;
+        ::close(in);
+        ::close(out);
+        if (!ok) {
+            ::unlink(copyPath);
+            throw std::runtime_error("Failed to copy " + libraryPath);
+        }
+        return copyPath;
+    }
+
+    static void unload(Loaded &loaded) {
+        if (loaded.instance) loaded.api->destroy(loaded.instance);
+        if (loaded.handle) dlclose(loaded.handle);
+        loaded = Loaded{};
+    }
+
+    StrategyHost host{};
+    Loaded current;
+    std::string path;
+    std::atomic<bool> reloadRequested{false};
+};
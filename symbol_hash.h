@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <immintrin.h>
+
+#include "cpu_dispatch.h"
+
+// Hash of short symbol strings for the in memory price maps
+// The SSE4.2 version uses the CRC32C instruction, the baseline one a multiply/xorshift mix
+// The two give different values, so hashes are only meaningful inside one process: never persist them
+
+using SymbolHashFn = std::size_t (*)(const char *, std::size_t);
+
+// Last 1..7 bytes of a key as a zero padded word
+inline uint64_t loadTail(const char *p, std::size_t n) {
+    uint64_t word = 0;
+    std::memcpy(&word, p, n);
+    return word;
+}
+
+inline std::size_t symbolHashBaseline(const char *p, std::size_t n) {
+    uint64_t h = 0x9e3779b97f4a7c15ull ^ n;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = (h ^ word) * 0xff51afd7ed558ccdull;
+        h ^= h >> 32;
+    }
+    if (n > 0) {
+        h = (h ^ loadTail(p, n)) * 0xff51afd7ed558ccdull;
+        h ^= h >> 32;
+    }
+    return static_cast<std::size_t>(h * 0xc4ceb9fe1a85ec53ull);
+}
+
+__attribute__((target("sse4.2")))
+inline std::size_t symbolHashSse42(const char *p, std::size_t n) {
+    uint64_t crc = 0xffffffffu ^ n;
+    for (; n >= 8; p += 8, n -= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        crc = _mm_crc32_u64(crc, word);
+    }
+    if (n > 0) crc = _mm_crc32_u64(crc, loadTail(p, n));
+    // CRC32C leaves the top half empty, spread it over all 64 bits for bucket selection
+    return static_cast<std::size_t>((crc | (crc << 32)) * 0x9e3779b97f4a7c15ull);
+}
+
+inline const SymbolHashFn symbolHash = selectKernel<SymbolHashFn>(symbolHashBaseline, symbolHashSse42, nullptr, nullptr);
+
+// HashCompare for tbb::concurrent_hash_map keyed by symbol
+struct SymbolHashCompare {
+    static std::size_t hash(const std::string &key) { return symbolHash(key.data(), key.size()); }
+    static bool equal(const std::string &a, const std::string &b) { return a == b; }
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Dense integer id of a symbol, used to index flat per symbol arrays
+using SymbolId = uint32_t;
+
+constexpr SymbolId invalidSymbol = ~SymbolId(0);
+
+// Interns symbol names into dense ids in registration order
+// Fill it at startup, lookups are safe from any thread once no more symbols are added
+class SymbolTable {
+public:
+    SymbolId intern(const std::string &name) {
+        auto it = ids.find(name);
+        if (it != ids.end()) return it->second;
+        SymbolId id = static_cast<SymbolId>(names.size());
+        ids.emplace(name, id);
+        names.push_back(name);
+        return id;
+    }
+
+    SymbolId find(const std::string &name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? invalidSymbol : it->second;
+    }
+
+    const std::string &name(SymbolId id) const { return names[id]; }
+    std::size_t size() const { return names.size(); }
+
+private:
+    std::unordered_map<std::string, SymbolId> ids;
+    std::vector<std::string> names;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "parse_kernels.h"
+
+// Number formatting and parsing for the text paths (console lines, JSON, CSV), on std::to_chars /
+// std::from_chars: no locale, no streams, no allocation beyond the output string's own growth
+// Fixed point values (prices on the wire are int64 with 4 decimals) are formatted and parsed
+// exactly, without going through a double
+
+// Shortest text that reads back as the same double
+inline void appendDouble(std::string &out, double value) {
+    char text[32];
+    out.append(text, std::to_chars(text, text + sizeof(text), value).ptr);
+}
+
+// precision significant digits, the same text as printf %g and a default formatted ostream
+inline void appendDouble(std::string &out, double value, int precision) {
+    char text[64];
+    out.append(text, std::to_chars(text, text + sizeof(text), value, std::chars_format::general, precision).ptr);
+}
+
+template <typename Integer>
+void appendInteger(std::string &out, Integer value) {
+    static_assert(std::is_integral<Integer>::value, "appendInteger takes integers");
+    char text[24];
+    out.append(text, std::to_chars(text, text + sizeof(text), value).ptr);
+}
+
+// value / 10^decimals with exactly decimals digits after the point, e.g. (1234500, 4) is 123.4500
+inline void appendFixed(std::string &out, int64_t value, unsigned decimals) {
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    char digits[24];
+    char *end = std::to_chars(digits, digits + sizeof(digits), magnitude).ptr;
+    std::size_t count = static_cast<std::size_t>(end - digits);
+    if (value < 0) out += '-';
+    if (count <= decimals) {
+        out += '0';
+    } else {
+        out.append(digits, count - decimals);
+    }
+    if (decimals == 0) return;
+    out += '.';
+    if (count < decimals) out.append(decimals - count, '0');
+    out.append(count <= decimals ? digits : end - decimals, end);
+}
+
+// The whole of [first, last) as a double, false if it isn't exactly one number
+inline bool parseDouble(const char *first, const char *last, double &out) {
+    auto result = std::from_chars(first, last, out);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+template <typename Integer>
+bool parseInteger(const char *first, const char *last, Integer &out) {
+    auto result = std::from_chars(first, last, out);
+    return result.ec == std::errc() && result.ptr == last;
+}
+
+// Decimal text to value * 10^decimals, digits past decimals round half away from zero
+inline bool parseFixed(const char *first, const char *last, int64_t &out, unsigned decimals) {
+    bool negative = first < last && *first == '-';
+    if (negative || (first < last && *first == '+')) ++first;
+    uint64_t value = 0;
+    unsigned fraction = 0; // Digits taken after the point
+    bool point = false, digits = false, dropped = false, roundUp = false;
+    for (const char *p = first; p < last; ++p) {
+        if (*p == '.' && !point) {
+            point = true;
+            continue;
+        }
+        if (*p < '0' || *p > '9') return false;
+        digits = true;
+        if (point && fraction == decimals) {
+            if (!dropped) roundUp = *p >= '5'; // Only the first dropped digit decides
+            dropped = true;
+            continue;
+        }
+        if (value > (UINT64_MAX - 9) / 10) return false;
+        value = value * 10 + static_cast<uint64_t>(*p - '0');
+        if (point) ++fraction;
+    }
+    if (!digits) return false;
+    for (; fraction < decimals; ++fraction) {
+        if (value > UINT64_MAX / 10) return false;
+        value *= 10;
+    }
+    if (roundUp) ++value;
+    if (value > static_cast<uint64_t>(INT64_MAX)) return false;
+    out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+    return true;
+}
+
+// Walks delimited text (CSV without quoting) a line at a time, lines end with \n or \r\n
+// Fields are found with the vectorized delimiter search (parse_kernels.h), one search per field
+class CsvCursor {
+public:
+    CsvCursor(const char *begin, const char *end, char separator = ',') : p(begin), end(end), separator(separator) {}
+
+    // Splits the next line into fields (views into the text), false at the end of the text
+    bool next(std::vector<std::string_view> &fields) {
+        fields.clear();
+        if (p >= end) return false;
+        while (true) {
+            const char *stop = findDelimiter(p, end, separator, '\n');
+            const char *fieldEnd = stop;
+            bool lineEnd = stop == end || *stop == '\n';
+            if (lineEnd && fieldEnd > p && fieldEnd[-1] == '\r') --fieldEnd;
+            fields.emplace_back(p, static_cast<std::size_t>(fieldEnd - p));
+            p = stop == end ? end : stop + 1;
+            if (lineEnd) return true;
+        }
+    }
+
+    // Where the next line starts
+    const char *position() const { return p; }
+
+private:
+    const char *p;
+    const char *end;
+    char separator;
+};
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "symbols.h"
+
+// Broadcast ring of price updates in POSIX shared memory, one writer process, any number of
+// reader processes; every update is written once and each reader follows it with its own cursor,
+// nothing is copied per reader and neither side makes a system call per tick
+// Slots are seqlocks like PriceHistory's: stamp is 0 while being written and the update's
+// sequence number once complete, a reader that finds a newer sequence than its cursor was lapped
+// and skips ahead, counting the updates it missed
+// Symbol names are published in the header so readers can resolve ids
+
+constexpr const char *defaultBroadcastName = "/lowlatency-ticks";
+constexpr std::size_t broadcastCapacity = 1 << 16;
+constexpr std::size_t broadcastMaxSymbols = 1024;
+constexpr std::size_t broadcastSymbolLength = 16;
+
+struct BroadcastTick {
+    uint64_t seq;
+    SymbolId symbol;
+    double price;
+    int64_t timestamp;
+};
+
+namespace broadcast_detail {
+
+constexpr uint64_t magic = 0x6c6c7469636b7331; // "llticks1"
+constexpr uint32_t version = 1;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory atomics must be lock free");
+
+struct Slot {
+    std::atomic<uint64_t> stamp;
+    std::atomic<uint32_t> symbol;
+    std::atomic<double> price;
+    std::atomic<int64_t> timestamp;
+};
+
+struct Layout {
+    std::atomic<uint64_t> magic; // Written last by the writer, readers check it first
+    uint32_t version;
+    uint32_t capacity;
+    std::atomic<uint32_t> symbolCount;
+    char symbolNames[broadcastMaxSymbols][broadcastSymbolLength];
+    alignas(64) std::atomic<uint64_t> head; // Sequence of the newest update, 0 before the first
+    alignas(64) Slot slots[broadcastCapacity];
+};
+
+} // namespace broadcast_detail
+
+class TickBroadcastWriter {
+public:
+    // Creates (or replaces) the shared memory object name, throws if it can't
+    explicit TickBroadcastWriter(const std::string &name = defaultBroadcastName) : name(name) {
+        ::shm_unlink(name.c_str()); // Readers of a previous writer keep their old mapping
+        int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (fd < 0) throw std::runtime_error("cannot create shared memory " + name);
+        if (::ftruncate(fd, sizeof(broadcast_detail::Layout)) != 0) {
+            ::close(fd);
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("cannot size shared memory " + name);
+        }
+        void *p = ::mmap(nullptr, sizeof(broadcast_detail::Layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            ::shm_unlink(name.c_str());
+            throw std::runtime_error("cannot mmap shared memory " + name);
+        }
+        // A fresh object is zero filled, which is the empty state of every slot
+        layout = static_cast<broadcast_detail::Layout *>(p);
+        layout->version = broadcast_detail::version;
+        layout->capacity = broadcastCapacity;
+        layout->magic.store(broadcast_detail::magic, std::memory_order_release);
+    }
+
+    ~TickBroadcastWriter() {
+        ::munmap(layout, sizeof(broadcast_detail::Layout));
+        ::shm_unlink(name.c_str());
+    }
+
+    TickBroadcastWriter(const TickBroadcastWriter&) = delete;
+    TickBroadcastWriter& operator=(const TickBroadcastWriter&) = delete;
+
+    // Publish the name of id, register every symbol before publishing its updates
+    void setSymbol(SymbolId id, const std::string &symbol) {
+        if (id >= broadcastMaxSymbols) throw std::runtime_error("too many symbols for the broadcast ring");
+        std::strncpy(layout->symbolNames[id], symbol.c_str(), broadcastSymbolLength - 1);
+        uint32_t count = layout->symbolCount.load(std::memory_order_relaxed);
+        if (id >= count) layout->symbolCount.store(id + 1, std::memory_order_release);
+    }
+
+    // Writer side, only one thread may call this
+    void publish(SymbolId symbol, double price, int64_t timestamp) {
+        uint64_t seq = layout->head.load(std::memory_order_relaxed) + 1;
+        broadcast_detail::Slot &slot = layout->slots[(seq - 1) & (broadcastCapacity - 1)];
+        slot.stamp.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.symbol.store(symbol, std::memory_order_relaxed);
+        slot.price.store(price, std::memory_order_relaxed);
+        slot.timestamp.store(timestamp, std::memory_order_relaxed);
+        slot.stamp.store(seq, std::memory_order_release);
+        layout->head.store(seq, std::memory_order_release);
+    }
+
+private:
+    std::string name;
+    broadcast_detail::Layout *layout = nullptr;
+};
+
+class TickBroadcastReader {
+public:
+    // Maps the ring read only, the cursor starts after the newest update, throws if no writer
+    // created name yet
+    explicit TickBroadcastReader(const std::string &name = defaultBroadcastName) {
+        int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) throw std::runtime_error("no tick broadcast at " + name);
+        void *p = ::mmap(nullptr, sizeof(broadcast_detail::Layout), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("cannot mmap shared memory " + name);
+        layout = static_cast<const broadcast_detail::Layout *>(p);
+        if (layout->magic.load(std::memory_order_acquire) != broadcast_detail::magic ||
+            layout->version != broadcast_detail::version || layout->capacity != broadcastCapacity) {
+            ::munmap(const_cast<broadcast_detail::Layout *>(layout), sizeof(broadcast_detail::Layout));
+            throw std::runtime_error("incompatible tick broadcast at " + name);
+        }
+        cursor = layout->head.load(std::memory_order_acquire) + 1;
+    }
+
+    ~TickBroadcastReader() { ::munmap(const_cast<broadcast_detail::Layout *>(layout), sizeof(broadcast_detail::Layout)); }
+
+    TickBroadcastReader(const TickBroadcastReader&) = delete;
+    TickBroadcastReader& operator=(const TickBroadcastReader&) = delete;
+
+    // Id of a symbol name, invalidSymbol if the writer hasn't published it
+    SymbolId find(const std::string &symbol) const {
+        uint32_t count = layout->symbolCount.load(std::memory_order_acquire);
+        for (uint32_t id = 0; id < count; ++id) {
+            if (symbol == layout->symbolNames[id]) return id;
+        }
+        return invalidSymbol;
+    }
+
+    const char *name(SymbolId id) const { return layout->symbolNames[id]; }
+
+    // Calls fn(const BroadcastTick &) for every update after the cursor, up to limit of them,
+    // returns how many were delivered
+    template <typename Fn>
+    std::size_t poll(Fn &&fn, std::size_t limit = broadcastCapacity) {
+        std::size_t delivered = 0;
+        while (delivered < limit) {
+            BroadcastTick tick;
+            uint64_t stamp = read(cursor, tick);
+            if (stamp == cursor) {
+                fn(static_cast<const BroadcastTick &>(tick));
+                ++cursor;
+                ++delivered;
+                continue;
+            }
+            // An older stamp means caught up, 0 means the slot is being written, retry later
+            if (stamp < cursor) break;
+            // Lapped: skip ahead, leaving half the ring as slack before the writer gets there again
+            uint64_t head = layout->head.load(std::memory_order_acquire);
+            uint64_t oldest = head - broadcastCapacity / 2 + 1;
+            missedTicks += oldest - cursor;
+            cursor = oldest;
+        }
+        return delivered;
+    }
+
+    // Updates overwritten before this reader got to them
+    uint64_t missed() const { return missedTicks; }
+
+    // Updates published but not read yet
+    uint64_t backlog() const { return layout->head.load(std::memory_order_acquire) + 1 - cursor; }
+
+private:
+    // Seqlock read of the slot for seq, returns the stamp found (seq when out holds that update)
+    uint64_t read(uint64_t seq, BroadcastTick &out) const {
+        const broadcast_detail::Slot &slot = layout->slots[(seq - 1) & (broadcastCapacity - 1)];
+        uint64_t before = slot.stamp.load(std::memory_order_acquire);
+        out.symbol = slot.symbol.load(std::memory_order_relaxed);
+        out.price = slot.price.load(std::memory_order_relaxed);
+        out.timestamp = slot.timestamp.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = slot.stamp.load(std::memory_order_relaxed);
+        out.seq = seq;
+        return before == after ? before : 0;
+    }
+
+    const broadcast_detail::Layout *layout = nullptr;
+    uint64_t cursor = 1;
+    uint64_t missedTicks = 0;
+};
@@ -0,0 +1,327 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/resource.h>
+#include <tbb/global_control.h>
+#include <tbb/parallel_for.h>
+#include "mapped_file.h"
+#include "text_codec.h"
+#include "tick_store.h"
+
+// Imports CSV tick dumps into a tick store directory (tick_store.h), for --replay and the backtester
+// Lines are TIMESTAMP,SYMBOL,PRICE by default, --columns gives another order (- skips a field);
+// a first line that doesn't parse is taken as a header, later ones are counted and skipped
+// Each file is memory mapped and read a window at a time: the window is cut at line boundaries
+// into chunks parsed in parallel, then every symbol's ticks from the window are put in time order
+// in parallel and appended by a pool of store writers, each owning a share of the symbols
+// A symbol's ticks only have to be in time order across windows: one older than what this run
+// already wrote for its symbol, or not newer than what an earlier import left in the store,
+// is dropped and counted
+// Usage:
+//   ./tick_import --out DIR [--columns timestamp,symbol,price] [--time-unit ns|us|ms|s]
+//                 [--separator C] [--window MB] [--threads N] FILE...
+
+constexpr std::size_t chunkBytes = 8 << 20; // Unit of parallel parsing
+
+struct ImportOptions {
+    char separator = ',';
+    std::size_t timestampField = 0;
+    std::size_t symbolField = 1;
+    std::size_t priceField = 2;
+    std::size_t fieldCount = 3;        // Fields a line needs at least
+    unsigned timestampDecimals = 0;    // Fraction digits of the unit down to nanoseconds
+    std::size_t windowBytes = std::size_t(1) << 30;
+};
+
+// Ticks of one chunk grouped by symbol, in file order; names point into the mapped file
+struct ChunkTicks {
+    std::unordered_map<std::string_view, std::size_t> index;
+    std::vector<std::string_view> names;
+    std::vector<std::vector<Tick>> ticks;
+    uint64_t malformed = 0;
+};
+
+// Symbols become file names in the store
+bool validSymbol(std::string_view name) {
+    if (name.empty() || name.size() > 64 || name == "." || name == "..") return false;
+    return name.find('/') == std::string_view::npos && name.find('\0') == std::string_view::npos;
+}
+
+void parseChunk(const char *begin, const char *end, bool startsFile, const ImportOptions &options, ChunkTicks &out) {
+    CsvCursor cursor(begin, end, options.separator);
+    std::vector<std::string_view> fields;
+    bool header = startsFile;
+    std::size_t last = 0; // Symbol of the previous line, dumps often repeat it
+    while (cursor.next(fields)) {
+        bool first = header;
+        header = false;
+        if (fields.size() == 1 && fields[0].empty()) continue;
+        Tick tick;
+        if (fields.size() < options.fieldCount) {
+            out.malformed += !first;
+            continue;
+        }
+        std::string_view time = fields[options.timestampField], price = fields[options.priceField];
+        std::string_view name = fields[options.symbolField];
+        if (!parseFixed(time.data(), time.data() + time.size(), tick.timestamp, options.timestampDecimals) ||
+            !parseDouble(price.data(), price.data() + price.size(), tick.price) || !validSymbol(name)) {
+            out.malformed += !first;
+            continue;
+        }
+        if (last >= out.names.size() || out.names[last] != name) {
+            auto inserted = out.index.try_emplace(name, out.names.size());
+            if (inserted.second) {
+                out.names.push_back(name);
+                out.ticks.emplace_back();
+            }
+            last = inserted.first->second;
+        }
+        out.ticks[last].push_back(tick);
+    }
+}
+
+// Start of the line after p, or end
+const char *nextLine(const char *p, const char *end) {
+    const char *newline = findDelimiter(p, end, '\n', '\n');
+    return newline == end ? end : newline + 1;
+}
+
+class TickImporter {
+public:
+    TickImporter(const std::string &directory, const ImportOptions &options, std::size_t writerCount)
+        : options(options) {
+        if (std::filesystem::exists(directory)) {
+            // Appending to an existing store: ticks must continue after what each symbol has
+            TickStoreReader existing(directory);
+            for (const auto &name : existing.symbols()) {
+                std::size_t count;
+                const TickBlockIndex *index = existing.blockIndex(name, count);
+                // Not newer than the store is taken as already imported, so a file imported twice adds nothing
+                if (count) symbolFor(name).lastTimestamp = index[count - 1].lastTimestamp + 1;
+            }
+        }
+        // Writers keep two files open per symbol, half of the process's descriptors go to them
+        rlimit limit{};
+        std::size_t descriptors = getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY ? limit.rlim_cur : 1024;
+        std::size_t openSymbols = descriptors / 4 / writerCount;
+        for (std::size_t i = 0; i < writerCount; ++i) writers.push_back(std::make_unique<TickStoreWriter>(directory, openSymbols));
+    }
+
+    void importFile(const std::string &path) {
+        MappedFile file(path);
+        file.adviseSequential();
+        const char *begin = reinterpret_cast<const char *>(file.data());
+        const char *end = begin + file.size();
+        for (const char *window = begin; window < end;) {
+            const char *windowEnd = end - window > static_cast<std::ptrdiff_t>(options.windowBytes)
+                ? nextLine(window + options.windowBytes, end) : end;
+            importWindow(window, windowEnd, window == begin);
+            window = windowEnd;
+        }
+        bytes += file.size();
+    }
+
+    // Write out the last partial blocks
+    void finish() {
+        tbb::parallel_for(std::size_t(0), writers.size(), [this](std::size_t w) { writers[w]->flush(); });
+    }
+
+    uint64_t bytesRead() const { return bytes; }
+    uint64_t malformedLines() const { return malformed; }
+    std::size_t symbolCount() const { return symbols.size(); }
+
+    uint64_t ticksImported() const {
+        uint64_t total = 0;
+        for (const auto &symbol : symbols) total += symbol->imported;
+        return total;
+    }
+
+    uint64_t ticksDropped() const {
+        uint64_t total = 0;
+        for (const auto &symbol : symbols) total += symbol->dropped;
+        return total;
+    }
+
+private:
+    struct SymbolState {
+        std::string name;
+        std::size_t writer;
+        int64_t lastTimestamp = std::numeric_limits<int64_t>::min(); // Earliest tick still accepted
+        uint64_t imported = 0;
+        uint64_t dropped = 0;
+        std::vector<std::pair<std::size_t, std::size_t>> parts; // (chunk, symbol in chunk) of this window
+        std::vector<Tick> ticks;                                 // This window's, in time order
+    };
+
+    SymbolState &symbolFor(std::string_view name) {
+        auto it = symbolIds.find(std::string(name));
+        if (it != symbolIds.end()) return *symbols[it->second];
+        auto state = std::make_unique<SymbolState>();
+        state->name = std::string(name);
+        state->writer = symbols.size(); // Spread over the writers in order of first appearance
+        symbolIds.emplace(state->name, symbols.size());
+        symbols.push_back(std::move(state));
+        return *symbols.back();
+    }
+
+    void importWindow(const char *begin, const char *end, bool startsFile) {
+        std::vector<const char *> cuts{begin};
+        while (cuts.back() < end) cuts.push_back(end - cuts.back() > static_cast<std::ptrdiff_t>(chunkBytes) ? nextLine(cuts.back() + chunkBytes, end) : end);
+        std::vector<ChunkTicks> chunks(cuts.size() - 1);
+        tbb::parallel_for(std::size_t(0), chunks.size(), [&](std::size_t c) {
+            parseChunk(cuts[c], cuts[c + 1], startsFile && c == 0, options, chunks[c]);
+        });
+
+        // Collect each symbol's pieces in file order, so equal timestamps keep their order
+        std::vector<SymbolState *> touched;
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            malformed += chunks[c].malformed;
+            for (std::size_t i = 0; i < chunks[c].names.size(); ++i) {
+                SymbolState &symbol = symbolFor(chunks[c].names[i]);
+                if (symbol.parts.empty()) touched.push_back(&symbol);
+                symbol.parts.emplace_back(c, i);
+            }
+        }
+
+        tbb::parallel_for(std::size_t(0), touched.size(), [&](std::size_t s) {
+            SymbolState &symbol = *touched[s];
+            symbol.ticks.clear();
+            for (const auto &part : symbol.parts) {
+                const std::vector<Tick> &ticks = chunks[part.first].ticks[part.second];
+                symbol.ticks.insert(symbol.ticks.end(), ticks.begin(), ticks.end());
+            }
+            symbol.parts.clear();
+            auto earlier = [](const Tick &a, const Tick &b) { return a.timestamp < b.timestamp; };
+            if (!std::is_sorted(symbol.ticks.begin(), symbol.ticks.end(), earlier)) {
+                std::stable_sort(symbol.ticks.begin(), symbol.ticks.end(), earlier);
+            }
+            auto late = std::lower_bound(symbol.ticks.begin(), symbol.ticks.end(), Tick{symbol.lastTimestamp, 0.0}, earlier);
+            symbol.dropped += static_cast<uint64_t>(late - symbol.ticks.begin());
+            symbol.ticks.erase(symbol.ticks.begin(), late);
+        });
+
+        tbb::parallel_for(std::size_t(0), writers.size(), [&](std::size_t w) {
+            for (SymbolState *symbol : touched) {
+                if (symbol->writer % writers.size() != w || symbol->ticks.empty()) continue;
+                writers[w]->append(symbol->name, symbol->ticks.data(), symbol->ticks.size());
+                symbol->lastTimestamp = symbol->ticks.back().timestamp;
+                symbol->imported += symbol->ticks.size();
+                symbol->ticks.clear();
+                symbol->ticks.shrink_to_fit();
+            }
+        });
+    }
+
+    ImportOptions options;
+    std::vector<std::unique_ptr<TickStoreWriter>> writers;
+    std::unordered_map<std::string, std::size_t> symbolIds;
+    std::vector<std::unique_ptr<SymbolState>> symbols;
+    uint64_t bytes = 0;
+    uint64_t malformed = 0;
+};
+
+// A whole number above 0
+bool parsePositive(const std::string &text, std::size_t &out) {
+    return parseInteger(text.data(), text.data() + text.size(), out) && out > 0;
+}
+
+int main(int argc, char **argv) {
+    ImportOptions options;
+    std::string directory;
+    std::vector<std::string> files;
+    std::size_t threads = std::thread::hardware_concurrency();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--out" && hasValue) {
+            directory = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            std::string value = argv[++i];
+            if (!parsePositive(value, threads)) {
+                std::cerr << "Bad --threads " << value << ", expected a positive count" << std::endl;
+                return 1;
+            }
+        } else if (arg == "--window" && hasValue) {
+            std::string value = argv[++i];
+            std::size_t megabytes;
+            if (!parsePositive(value, megabytes) || megabytes > (std::numeric_limits<std::size_t>::max() >> 20)) {
+                std::cerr << "Bad --window " << value << ", expected a positive size in MB" << std::endl;
+                return 1;
+            }
+            options.windowBytes = megabytes << 20;
+        } else if (arg == "--separator" && hasValue) {
+            std::string value = argv[++i];
+            if (value.size() != 1 || value[0] == '\n') {
+                std::cerr << "Bad --separator " << value << ", expected one character other than a newline" << std::endl;
+                return 1;
+            }
+            options.separator = value[0];
+        } else if (arg == "--time-unit" && hasValue) {
+            std::string unit = argv[++i];
+            if (unit != "ns" && unit != "us" && unit != "ms" && unit != "s") {
+                std::cerr << "Bad --time-unit " << unit << ", expected ns, us, ms or s" << std::endl;
+                return 1;
+            }
+            options.timestampDecimals = unit == "s" ? 9 : unit == "ms" ? 6 : unit == "us" ? 3 : 0;
+        } else if (arg == "--columns" && hasValue) {
+            std::string columns = argv[++i];
+            std::vector<std::string_view> names;
+            CsvCursor(columns.data(), columns.data() + columns.size()).next(names);
+            // Each of the three exactly once, anything else is a skipped field (-)
+            constexpr std::size_t missing = ~std::size_t(0);
+            options.timestampField = options.symbolField = options.priceField = missing;
+            bool valid = true;
+            for (std::size_t f = 0; f < names.size(); ++f) {
+                if (names[f] == "-") continue;
+                std::size_t *field = names[f] == "timestamp" ? &options.timestampField
+                                   : names[f] == "symbol"    ? &options.symbolField
+                                   : names[f] == "price"     ? &options.priceField : nullptr;
+                if (!field || *field != missing) valid = false;
+                else *field = f;
+            }
+            valid = valid && options.timestampField != missing && options.symbolField != missing && options.priceField != missing;
+            if (!valid) {
+                std::cerr << "Bad --columns " << columns << ", expected timestamp, symbol and price once each and - for skipped fields" << std::endl;
+                return 1;
+            }
+            options.fieldCount = names.size();
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (directory.empty() || files.empty()) {
+        std::cout << "Usage: " << argv[0] << " --out DIR [--columns timestamp,symbol,price] [--time-unit ns|us|ms|s]"
+                  << " [--separator C] [--window MB] [--threads N] FILE..." << std::endl;
+        return 1;
+    }
+    threads = std::max<std::size_t>(threads, 1);
+    tbb::global_control parallelism(tbb::global_control::max_allowed_parallelism, threads);
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<TickImporter> importer;
+    try {
+        importer = std::make_unique<TickImporter>(directory, options, threads);
+        for (const auto &file : files) importer->importFile(file);
+        importer->finish();
+    } catch (const std::exception &e) {
+        std::cerr << "Import failed: " << e.what() << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t ticks = importer->ticksImported();
+    std::cout << "Imported " << ticks << " ticks of " << importer->symbolCount() << " symbols from "
+              << importer->bytesRead() / 1e6 << " MB in " << seconds << " s (" << importer->bytesRead() / seconds / 1e6
+              << " MB/s, " << ticks / seconds / 1e6 << "M ticks/s) on " << threads << " threads" << std::endl;
+    if (importer->ticksDropped()) std::cout << importer->ticksDropped() << " ticks not after their symbol's stored ticks dropped" << std::endl;
+    if (importer->malformedLines()) std::cout << importer->malformedLines() << " malformed lines skipped" << std::endl;
+    return 0;
+}
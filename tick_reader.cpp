@@ -0,0 +1,62 @@
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "latency_histogram.h"
+#include "price_history.h"
+#include "tick_broadcast.h"
+
+// Follows the tick broadcast ring of a running main --broadcast NAME from another process
+// Sees every update, keeps the last price per symbol and once a second prints the watched ones
+// together with the publish to read latency and how many updates it fell behind on
+// Usage:
+//   ./tick_reader [--name NAME] [SYMBOL...]     default NAME /lowlatency-ticks, default AAPL GOOGL MSFT
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void handleSignal(int) {
+    stopRequested = 1;
+}
+
+int main(int argc, char **argv) {
+    std::string name = defaultBroadcastName;
+    std::vector<std::string> watched;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--name" && i + 1 < argc) name = argv[++i];
+        else watched.push_back(arg);
+    }
+    if (watched.empty()) watched = {"AAPL", "GOOGL", "MSFT"};
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+
+    TickBroadcastReader reader(name);
+    std::vector<double> lastPrice(broadcastMaxSymbols, 0.0);
+    LatencyHistogram latency;
+    uint64_t ticks = 0;
+    int64_t nextReport = wallClockNanos() + 1000000000;
+
+    // Busy polls, a reader that can't spare a core can sleep between polls and rely on the ring's depth
+    while (!stopRequested) {
+        std::size_t n = reader.poll([&](const BroadcastTick &tick) {
+            if (tick.symbol < lastPrice.size()) lastPrice[tick.symbol] = tick.price;
+            latency.record(wallClockNanos() - tick.timestamp);
+        });
+        ticks += n;
+        if (n == 0) __builtin_ia32_pause();
+
+        int64_t now = wallClockNanos();
+        if (now < nextReport) continue;
+        nextReport = now + 1000000000;
+        for (const auto &symbol : watched) {
+            SymbolId id = reader.find(symbol);
+            if (id == invalidSymbol) std::cout << "Stock not found: " << symbol << std::endl;
+            else std::cout << "Stock: " << symbol << " Price: $" << lastPrice[id] << std::endl;
+        }
+        std::cout << "Reader: " << ticks << " ticks, " << reader.missed() << " missed | publish to read p50 "
+                  << latency.percentile(50) << " ns p99 " << latency.percentile(99) << " ns" << std::endl;
+        latency.reset();
+    }
+    return 0;
+}
@@ -0,0 +1,479 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mapped_file.h"
+#include "scan_kernels.h"
+
+// Columnar on disk tick store
+// Every symbol gets two append only files in the store directory:
+//   SYMBOL.blk  compressed blocks, a timestamp column followed by a price column
+//   SYMBOL.idx  one fixed size TickBlockIndex per block, memory mapped by readers
+// Timestamps are delta of delta encoded, zigzagged and bit packed at one width per block,
+// prices are XOR compressed the way Gorilla does it
+// Timestamps must be non decreasing per symbol
+
+// Ticks per block, a block is decoded as a unit so it has to fit comfortably in L1
+constexpr std::size_t ticksPerBlock = 1024;
+
+// One historical price update
+struct Tick {
+    int64_t timestamp;
+    double price;
+};
+
+// Index entry of one compressed block, written to SYMBOL.idx as is
+struct TickBlockIndex {
+    int64_t firstTimestamp;
+    int64_t lastTimestamp;
+    int64_t firstDelta;     // ts[1] - ts[0], kept out of the packed column so it doesn't set the width
+    double minPrice;
+    double maxPrice;
+    uint64_t offset;        // Start of the block in SYMBOL.blk
+    uint32_t timestampBytes;
+    uint32_t priceBytes;
+    uint32_t count;
+    uint8_t timestampBits;  // Width of each packed delta of delta, 0 when the spacing is constant
+    uint8_t reserved[3];
+};
+static_assert(sizeof(TickBlockIndex) == 64, "TickBlockIndex is part of the on disk format");
+
+// Pack n values LSB first, value i occupies bits [i * bits, (i + 1) * bits)
+inline void packBits(const uint64_t *values, std::size_t n, unsigned bits, uint8_t *out) {
+    std::memset(out, 0, packedBytes(n, bits));
+    if (bits == 0) return;
+    for (std::size_t i = 0; i < n; ++i) {
+        std::size_t bit = i * bits;
+        unsigned shift = bit & 63;
+        uint64_t word;
+        std::memcpy(&word, out + (bit >> 6) * 8, 8);
+        word |= values[i] << shift;
+        std::memcpy(out + (bit >> 6) * 8, &word, 8);
+        if (shift + bits > 64) {
+            std::memcpy(&word, out + (bit >> 6) * 8 + 8, 8);
+            word |= values[i] >> (64 - shift);
+            std::memcpy(out + (bit >> 6) * 8 + 8, &word, 8);
+        }
+    }
+}
+
+// MSB first bit stream used by the XOR price column
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t> &out) : out(out) {}
+
+    void write(uint64_t value, unsigned bits) {
+        while (bits > 0) {
+            unsigned take = std::min(8u - fill, bits);
+            uint8_t chunk = static_cast<uint8_t>((value >> (bits - take)) & ((1u << take) - 1));
+            current = static_cast<uint8_t>((current << take) | chunk);
+            fill += take;
+            bits -= take;
+            if (fill == 8) {
+                out.push_back(current);
+                current = 0;
+                fill = 0;
+            }
+        }
+    }
+
+    // Flush the partial byte and pad so readers can always load 8 bytes
+    void finish() {
+        if (fill > 0) out.push_back(static_cast<uint8_t>(current << (8 - fill)));
+        out.insert(out.end(), 8, 0);
+        current = 0;
+        fill = 0;
+    }
+
+private:
+    std::vector<uint8_t> &out;
+    uint8_t current = 0;
+    unsigned fill = 0;
+};
+
+// Reads stay inside the size bytes at in, a stream that would run past them is corrupt and throws
+class BitReader {
+public:
+    BitReader(const uint8_t *in, std::size_t size) : in(in), size(size) {}
+
+    // bits in [1, 64]
+    uint64_t read(unsigned bits) {
+        if (bits > 56) {
+            uint64_t high = read(bits - 32);
+            return (high << 32) | read(32);
+        }
+        if ((position >> 3) + 8 > size) throw std::runtime_error("corrupt tick store price column");
+        uint64_t word;
+        std::memcpy(&word, in + (position >> 3), 8);
+        word = __builtin_bswap64(word) << (position & 7);
+        position += bits;
+        return word >> (64 - bits);
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+private:
+    const uint8_t *in;
+    std::size_t size;
+    std::size_t position = 0;
+};
+
+inline void encodePrices(const double *prices, std::size_t n, std::vector<uint8_t> &out) {
+    BitWriter writer(out);
+    uint64_t previous;
+    std::memcpy(&previous, &prices[0], 8);
+    writer.write(previous, 64);
+    int previousLeading = -1, previousTrailing = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        uint64_t value;
+        std::memcpy(&value, &prices[i], 8);
+        uint64_t x = value ^ previous;
+        previous = value;
+        if (x == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+        int leading = std::min(__builtin_clzll(x), 31);
+        int trailing = __builtin_ctzll(x);
+        if (previousLeading >= 0 && leading >= previousLeading && trailing >= previousTrailing) {
+            // Meaningful bits fit in the previous window
+            writer.write(0b10, 2);
+            writer.write(x >> previousTrailing, 64 - previousLeading - previousTrailing);
+        } else {
+            int meaningful = 64 - leading - trailing;
+            writer.write(0b11, 2);
+            writer.write(static_cast<uint64_t>(leading), 5);
+            writer.write(static_cast<uint64_t>(meaningful - 1), 6);
+            writer.write(x >> trailing, static_cast<unsigned>(meaningful));
+            previousLeading = leading;
+            previousTrailing = trailing;
+        }
+    }
+    writer.finish();
+}
+
+inline void decodePrices(const uint8_t *in, std::size_t bytes, std::size_t n, double *out) {
+    BitReader reader(in, bytes);
+    uint64_t value = reader.read(64);
+    std::memcpy(&out[0], &value, 8);
+    unsigned leading = 0, trailing = 0;
+    for (std::size_t i = 1; i < n; ++i) {
+        if (reader.readBit()) {
+            if (reader.readBit()) {
+                leading = static_cast<unsigned>(reader.read(5));
+                unsigned meaningful = static_cast<unsigned>(reader.read(6)) + 1;
+                if (leading + meaningful > 64) throw std::runtime_error("corrupt tick store price column");
+                trailing = 64 - leading - meaningful;
+            }
+            value ^= reader.read(64 - leading - trailing) << trailing;
+        }
+        std::memcpy(&out[i], &value, 8);
+    }
+}
+
+// Appends ticks to the store, buffering one block per symbol
+// A symbol's files are opened when its first block is written and stay open for the next ones,
+// up to maxOpenSymbols symbols (two files each); past that the longest open are closed
+// Not thread safe; writers on different threads can share a directory as long as each symbol is
+// only ever appended by one of them
+class TickStoreWriter {
+public:
+    explicit TickStoreWriter(const std::string &directory, std::size_t maxOpenSymbols = 256)
+        : directory(directory), maxOpenSymbols(std::max<std::size_t>(maxOpenSymbols, 1)) {
+        std::filesystem::create_directories(directory);
+    }
+
+    TickStoreWriter(const TickStoreWriter&) = delete;
+    TickStoreWriter& operator=(const TickStoreWriter&) = delete;
+
+    ~TickStoreWriter() {
+        try {
+            flush();
+        } catch (...) {
+            // Nothing sensible to do with a write error while unwinding
+        }
+    }
+
+    void append(const std::string &symbol, int64_t timestamp, double price) {
+        Tick tick{timestamp, price};
+        append(symbol, &tick, 1);
+    }
+
+    // A run of ticks of one symbol, in time order
+    void append(const std::string &symbol, const Tick *ticks, std::size_t n) {
+        SymbolFiles &files = filesFor(symbol);
+        for (std::size_t i = 0; i < n; ++i) {
+            if (ticks[i].timestamp < files.lastTimestamp) {
+                throw std::invalid_argument("tick store timestamps must be non decreasing for " + symbol);
+            }
+            files.lastTimestamp = ticks[i].timestamp;
+            files.timestamps[files.count] = ticks[i].timestamp;
+            files.prices[files.count] = ticks[i].price;
+            if (++files.count == ticksPerBlock) writeBlock(files);
+        }
+    }
+
+    // Write out every partially filled block, readers opened afterwards will see them
+    void flush() {
+        for (auto &entry : symbols) {
+            if (entry.second->count > 0) writeBlock(*entry.second);
+            if (entry.second->data) {
+                std::fflush(entry.second->data);
+                std::fflush(entry.second->index);
+            }
+        }
+    }
+
+private:
+    struct SymbolFiles {
+        std::string symbol;
+        std::FILE *data = nullptr;
+        std::FILE *index = nullptr;
+        uint64_t dataSize = 0;
+        std::size_t count = 0;
+        int64_t lastTimestamp = std::numeric_limits<int64_t>::min(); // Newest tick appended, on disk or buffered
+        int64_t timestamps[ticksPerBlock];
+        double prices[ticksPerBlock];
+
+        void close() {
+            if (data) std::fclose(data);
+            if (index) std::fclose(index);
+            data = index = nullptr;
+        }
+
+        ~SymbolFiles() { close(); }
+    };
+
+    SymbolFiles &filesFor(const std::string &symbol) {
+        auto it = symbols.find(symbol);
+        if (it != symbols.end()) return *it->second;
+
+        auto files = std::make_unique<SymbolFiles>();
+        files->symbol = symbol;
+        std::string base = directory + "/" + symbol;
+        if (std::filesystem::exists(base + ".idx")) {
+            files->dataSize = std::filesystem::file_size(base + ".blk");
+            files->lastTimestamp = lastStoredTimestamp(base + ".idx");
+        }
+        return *symbols.emplace(symbol, std::move(files)).first->second;
+    }
+
+    void open(SymbolFiles &files) {
+        if (files.data) return;
+        if (openSymbols.size() >= maxOpenSymbols) {
+            openSymbols.front()->close();
+            openSymbols.pop_front();
+        }
+        std::string base = directory + "/" + files.symbol;
+        files.data = std::fopen((base + ".blk").c_str(), "ab");
+        files.index = std::fopen((base + ".idx").c_str(), "ab");
+        if (!files.data || !files.index) {
+            files.close();
+            throw std::runtime_error("cannot open tick store files for " + files.symbol);
+        }
+        openSymbols.push_back(&files);
+    }
+
+    // Last timestamp of an existing index, so appends to a reopened store stay in time order
+    static int64_t lastStoredTimestamp(const std::string &indexPath) {
+        uint64_t size = std::filesystem::file_size(indexPath);
+        if (size < sizeof(TickBlockIndex)) return std::numeric_limits<int64_t>::min();
+        std::FILE *index = std::fopen(indexPath.c_str(), "rb");
+        TickBlockIndex entry;
+        bool read = index && std::fseek(index, static_cast<long>(size / sizeof(entry) * sizeof(entry) - sizeof(entry)), SEEK_SET) == 0 &&
+                    std::fread(&entry, sizeof(entry), 1, index) == 1;
+        if (index) std::fclose(index);
+        if (!read) throw std::runtime_error("cannot read tick store index " + indexPath);
+        return entry.lastTimestamp;
+    }
+
+    void writeBlock(SymbolFiles &files) {
+        std::size_t n = files.count;
+        TickBlockIndex entry{};
+        entry.firstTimestamp = files.timestamps[0];
+        entry.lastTimestamp = files.timestamps[n - 1];
+        entry.firstDelta = n > 1 ? files.timestamps[1] - files.timestamps[0] : 0;
+        entry.minPrice = *std::min_element(files.prices, files.prices + n);
+        entry.maxPrice = *std::max_element(files.prices, files.prices + n);
+        entry.offset = files.dataSize;
+        entry.count = static_cast<uint32_t>(n);
+
+        // Slots 0 and 1 stay zero, ts[0] and the first delta live in the index entry
+        uint64_t column[ticksPerBlock] = {};
+        uint64_t widest = 0;
+        for (std::size_t i = 2; i < n; ++i) {
+            int64_t dod = (files.timestamps[i] - files.timestamps[i - 1]) - (files.timestamps[i - 1] - files.timestamps[i - 2]);
+            column[i] = zigzagEncode(dod);
+            widest |= column[i];
+        }
+        entry.timestampBits = static_cast<uint8_t>(widest ? 64 - __builtin_clzll(widest) : 0);
+
+        encoded.assign(packedBytes(n, entry.timestampBits), 0);
+        packBits(column, n, entry.timestampBits, encoded.data());
+        entry.timestampBytes = static_cast<uint32_t>(encoded.size());
+        encodePrices(files.prices, n, encoded);
+        entry.priceBytes = static_cast<uint32_t>(encoded.size() - entry.timestampBytes);
+
+        open(files);
+        if (std::fwrite(encoded.data(), 1, encoded.size(), files.data) != encoded.size() ||
+            std::fwrite(&entry, sizeof(entry), 1, files.index) != 1) {
+            throw std::runtime_error("tick store write failed");
+        }
+        files.dataSize += encoded.size();
+        files.count = 0;
+    }
+
+    std::string directory;
+    std::size_t maxOpenSymbols;
+    std::unordered_map<std::string, std::unique_ptr<SymbolFiles>> symbols;
+    std::deque<SymbolFiles *> openSymbols; // Oldest opened first
+    std::vector<uint8_t> encoded;
+};
+
+// Whether an index entry read from disk describes a block decodeTickBlock can decode inside
+// ticksPerBlock entries and a data file of dataSize bytes
+inline bool validTickBlock(const TickBlockIndex &entry, uint64_t dataSize) {
+    return entry.count >= 1 && entry.count <= ticksPerBlock && entry.timestampBits <= 64 &&
+           entry.firstTimestamp <= entry.lastTimestamp &&
+           entry.timestampBytes == packedBytes(entry.count, entry.timestampBits) &&
+           entry.priceBytes >= 16 && // First price and the reader's padding
+           entry.offset <= dataSize && dataSize - entry.offset >= uint64_t(entry.timestampBytes) + entry.priceBytes;
+}
+
+// Decodes one block into caller provided columns of at least ticksPerBlock entries
+inline void decodeTickBlock(const TickBlockIndex &entry, const uint8_t *data, int64_t *timestamps, double *prices) {
+    const ScanKernels &kernels = scanKernels();
+    alignas(64) uint64_t column[ticksPerBlock];
+    const uint8_t *block = data + entry.offset;
+    kernels.unpackBits(block, entry.count, entry.timestampBits, column);
+    kernels.decodeTimestamps(entry.firstTimestamp, entry.firstDelta, entry.count, column, timestamps);
+    decodePrices(block + entry.timestampBytes, entry.priceBytes, entry.count, prices);
+}
+
+// Range queries over a store directory, files are memory mapped on first use
+// A reader sees the blocks that were flushed before the symbol was first queried
+class TickStoreReader {
+public:
+    explicit TickStoreReader(const std::string &directory) : directory(directory) {}
+
+    // Symbols that have an index file in the store
+    std::vector<std::string> symbols() const {
+        std::vector<std::string> names;
+        for (const auto &file : std::filesystem::directory_iterator(directory)) {
+            if (file.path().extension() == ".idx") names.push_back(file.path().stem().string());
+        }
+        std::sort(names.begin(), names.end());
+        return names;
+    }
+
+    // Calls fn(const int64_t *timestamps, const double *prices, size_t n) with consecutive
+    // columnar runs of the ticks of symbol with from <= timestamp <= to, in time order
+    template <typename Fn>
+    void scanBlocks(const std::string &symbol, int64_t from, int64_t to, Fn &&fn) {
+        const SymbolMapping &mapping = mappingFor(symbol);
+        const TickBlockIndex *first = mapping.blocks();
+        const TickBlockIndex *last = first + mapping.blockCount();
+
+        // Blocks are in time order, skip straight to the first one that can overlap
+        const TickBlockIndex *block = std::lower_bound(first, last, from,
+            [](const TickBlockIndex &entry, int64_t t) { return entry.lastTimestamp < t; });
+
+        alignas(64) int64_t timestamps[ticksPerBlock];
+        alignas(64) double prices[ticksPerBlock];
+        for (; block != last && block->firstTimestamp <= to; ++block) {
+            decodeTickBlock(*block, mapping.data.data(), timestamps, prices);
+            std::size_t begin = 0, end = block->count;
+            if (block->firstTimestamp < from) {
+                begin = std::lower_bound(timestamps, timestamps + end, from) - timestamps;
+            }
+            if (block->lastTimestamp > to) {
+                end = std::upper_bound(timestamps + begin, timestamps + end, to) - timestamps;
+            }
+            if (begin < end) fn(timestamps + begin, prices + begin, end - begin);
+        }
+    }
+
+    // scanBlocks restricted to minPrice <= price <= maxPrice, blocks whose price range
+    // misses the predicate are skipped without being decoded
+    template <typename Fn>
+    void scanFiltered(const std::string &symbol, int64_t from, int64_t to, double minPrice, double maxPrice, Fn &&fn) {
+        const ScanKernels &kernels = scanKernels();
+        const SymbolMapping &mapping = mappingFor(symbol);
+        const TickBlockIndex *first = mapping.blocks();
+        const TickBlockIndex *last = first + mapping.blockCount();
+        const TickBlockIndex *block = std::lower_bound(first, last, from,
+            [](const TickBlockIndex &entry, int64_t t) { return entry.lastTimestamp < t; });
+
+        alignas(64) int64_t timestamps[ticksPerBlock];
+        alignas(64) double prices[ticksPerBlock];
+        for (; block != last && block->firstTimestamp <= to; ++block) {
+            if (block->maxPrice < minPrice || block->minPrice > maxPrice) continue;
+            decodeTickBlock(*block, mapping.data.data(), timestamps, prices);
+            std::size_t n = kernels.filterTicks(timestamps, prices, block->count, from, to,
+                                                minPrice, maxPrice, timestamps, prices);
+            if (n > 0) fn(static_cast<const int64_t *>(timestamps), static_cast<const double *>(prices), n);
+        }
+    }
+
+    // Tick by tick version of scanBlocks, fn(const Tick&)
+    template <typename Fn>
+    void scan(const std::string &symbol, int64_t from, int64_t to, Fn &&fn) {
+        scanBlocks(symbol, from, to, [&fn](const int64_t *timestamps, const double *prices, std::size_t n) {
+            for (std::size_t i = 0; i < n; ++i) fn(Tick{timestamps[i], prices[i]});
+        });
+    }
+
+    // Block index of a symbol, for callers that want to plan their own scans
+    const TickBlockIndex *blockIndex(const std::string &symbol, std::size_t &count) {
+        const SymbolMapping &mapping = mappingFor(symbol);
+        count = mapping.blockCount();
+        return mapping.blocks();
+    }
+
+    // Encoded blocks of a symbol, decode an index entry with decodeTickBlock(entry, blockData(symbol), ...)
+    const uint8_t *blockData(const std::string &symbol) { return mappingFor(symbol).data.data(); }
+
+private:
+    struct SymbolMapping {
+        MappedFile index;
+        MappedFile data;
+
+        const TickBlockIndex *blocks() const { return reinterpret_cast<const TickBlockIndex *>(index.data()); }
+        std::size_t blockCount() const { return index.size() / sizeof(TickBlockIndex); }
+    };
+
+    const SymbolMapping &mappingFor(const std::string &symbol) {
+        auto it = mappings.find(symbol);
+        if (it != mappings.end()) return it->second;
+
+        SymbolMapping mapping;
+        std::string base = directory + "/" + symbol;
+        mapping.index = MappedFile(base + ".idx");
+        mapping.data = MappedFile(base + ".blk");
+        mapping.data.adviseSequential();
+        // The index comes from disk, a bad entry must not send the decoder outside its columns
+        // or the mapping, and the blocks have to be in time order for the binary searches
+        for (std::size_t i = 0; i < mapping.blockCount(); ++i) {
+            const TickBlockIndex &entry = mapping.blocks()[i];
+            if (!validTickBlock(entry, mapping.data.size()) ||
+                (i > 0 && entry.firstTimestamp < mapping.blocks()[i - 1].lastTimestamp)) {
+                throw std::runtime_error("corrupt tick store index entry " + std::to_string(i) + " of " + symbol);
+            }
+        }
+        return mappings.emplace(symbol, std::move(mapping)).first->second;
+    }
+
+    std::string directory;
+    std::unordered_map<std::string, SymbolMapping> mappings;
+};
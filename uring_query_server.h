@@ -0,0 +1,293 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "io_uring.h"
+#include "query_protocol.h"
+#include "socket_util.h"
+
+// io_uring backend of the query server (query_protocol.h) on one thread, a drop in for QueryServer
+// Each listener has one multishot accept armed; accepted sockets go into the ring's fixed file
+// table and get one multishot receive that picks its buffers from a provided buffer ring, so a
+// connection costs no system call per message in either direction
+// Everything a pass produces (replies and the fan out of updates to every subscriber) is queued
+// as one send per connection and handed to the kernel by the same io_uring_enter that waits
+// for the next completions: a price pushed to thousands of subscribers is one system call
+// A connection has at most one send in flight, output queued meanwhile goes out when it
+// completes; one that falls maxOutbound bytes behind is dropped
+
+template <typename Source, typename Protocol = QueryProtocol<Source>>
+class UringQueryServer {
+public:
+    static constexpr std::size_t maxOutbound = 1 << 20;
+    static constexpr unsigned maxConnections = 16384;
+    static constexpr unsigned receiveBuffers = 4096; // Provided to the kernel, shared by all connections
+    static constexpr unsigned receiveBufferSize = 4096;
+
+    explicit UringQueryServer(const std::vector<std::string> &addresses)
+        : connections(maxConnections), ring(4096, 4 * maxConnections) {
+        ring.registerSparseFiles(maxConnections);
+        for (unsigned slot = maxConnections; slot > 0; --slot) freeSlots.push_back(slot - 1);
+
+        bufferRingSize = receiveBuffers * sizeof(io_uring_buf);
+        void *ringMemory = ::mmap(nullptr, bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ringMemory == MAP_FAILED) throw std::runtime_error("io_uring: cannot allocate the buffer ring");
+        bufferRing = static_cast<io_uring_buf_ring *>(ringMemory);
+        bufferMemory.resize(std::size_t(receiveBuffers) * receiveBufferSize);
+        ring.registerBufferRing(bufferRing, receiveBuffers, bufferGroup);
+        for (unsigned id = 0; id < receiveBuffers; ++id) returnBuffer(id);
+        publishBuffers();
+
+        for (const auto &address : addresses) {
+            int fd = listenOn(address);
+            listeners.push_back(fd);
+            unixPaths.push_back(isTcpAddress(address) ? std::string() : address);
+            armAccept(listeners.size() - 1);
+        }
+    }
+
+    ~UringQueryServer() {
+        for (int fd : listeners) ::close(fd);
+        for (const auto &path : unixPaths) {
+            if (!path.empty()) ::unlink(path.c_str());
+        }
+        ::munmap(bufferRing, bufferRingSize); // The kernel keeps the ring's pages pinned until it closes
+    }
+
+    UringQueryServer(const UringQueryServer&) = delete;
+    UringQueryServer& operator=(const UringQueryServer&) = delete;
+
+    // Server thread body, returns when running is cleared
+    void run(const std::atomic<bool> &running) {
+        ring.enable();
+        while (running.load(std::memory_order_relaxed)) {
+            ring.submitAndWait(1, 1000000);
+            ring.forEachCompletion([this](const io_uring_cqe &completion) { complete(completion); });
+            pushUpdates();
+            flush();
+            publishBuffers();
+        }
+    }
+
+    std::size_t connectionCount() const { return open; }
+
+    // System calls made by the server loop so far, to compare backends
+    uint64_t systemCalls() const { return ring.systemCalls() + extraCalls; }
+
+private:
+    enum Operation : uint64_t { AcceptOperation = 1, ReceiveOperation = 2, SendOperation = 3, CancelOperation = 4 };
+
+    struct Connection {
+        unsigned slot;
+        WireReader reader{8192};
+        std::vector<char> outbound; // Queued, goes out with the next send
+        std::vector<char> sending;  // Owned by the send in flight
+        std::size_t sendingOffset = 0;
+        unsigned inFlight = 0;      // Submitted operations whose last completion is still due
+        bool sendInFlight = false;
+        bool dirty = false;
+        bool closed = false;
+    };
+
+    static constexpr unsigned bufferGroup = 0;
+
+    // Completions carry the connection pointer (8 byte aligned) with the operation in the low bits
+    static uint64_t tag(Connection *connection, Operation operation) { return reinterpret_cast<uint64_t>(connection) | operation; }
+
+    void armAccept(std::size_t listener) {
+        io_uring_sqe &entry = ring.nextEntry();
+        entry.opcode = IORING_OP_ACCEPT;
+        entry.fd = listeners[listener];
+        entry.ioprio = IORING_ACCEPT_MULTISHOT;
+        entry.accept_flags = SOCK_CLOEXEC;
+        entry.user_data = (listener << 3) | AcceptOperation;
+    }
+
+    void armReceive(Connection &connection) {
+        io_uring_sqe &entry = ring.nextEntry();
+        entry.opcode = IORING_OP_RECV;
+        entry.fd = static_cast<int>(connection.slot);
+        entry.flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+        entry.ioprio = IORING_RECV_MULTISHOT;
+        entry.buf_group = bufferGroup;
+        entry.user_data = tag(&connection, ReceiveOperation);
+        ++connection.inFlight;
+    }
+
+    void submitSend(Connection &connection) {
+        io_uring_sqe &entry = ring.nextEntry();
+        entry.opcode = IORING_OP_SEND;
+        entry.fd = static_cast<int>(connection.slot);
+        entry.flags = IOSQE_FIXED_FILE;
+        entry.addr = reinterpret_cast<uint64_t>(connection.sending.data() + connection.sendingOffset);
+        entry.len = static_cast<uint32_t>(connection.sending.size() - connection.sendingOffset);
+        entry.msg_flags = MSG_NOSIGNAL;
+        entry.user_data = tag(&connection, SendOperation);
+        connection.sendInFlight = true;
+        ++connection.inFlight;
+    }
+
+    void complete(const io_uring_cqe &completion) {
+        auto operation = static_cast<Operation>(completion.user_data & 7);
+        if (operation == AcceptOperation) {
+            std::size_t listener = completion.user_data >> 3;
+            if (completion.res >= 0) accepted(completion.res);
+            if (!(completion.flags & IORING_CQE_F_MORE)) armAccept(listener);
+            return;
+        }
+
+        Connection &connection = *reinterpret_cast<Connection *>(completion.user_data & ~uint64_t(7));
+        bool last = operation != ReceiveOperation || !(completion.flags & IORING_CQE_F_MORE);
+        if (operation == ReceiveOperation) received(connection, completion);
+        else if (operation == SendOperation) sent(connection, completion.res);
+        else if (operation == CancelOperation) {
+            ring.updateFile(connection.slot, -1); // Drops the table's reference, the socket closes
+        }
+        if (last) --connection.inFlight;
+        if (connection.closed && connection.inFlight == 0) release(connection);
+    }
+
+    void accepted(int fd) {
+        if (freeSlots.empty()) {
+            ::close(fd);
+            return;
+        }
+        setNoDelay(fd);
+        unsigned slot = freeSlots.back();
+        freeSlots.pop_back();
+        ring.updateFile(slot, fd);
+        ::close(fd); // The fixed file table keeps the socket open
+        extraCalls += 2;
+        connections[slot] = std::make_unique<Connection>();
+        connections[slot]->slot = slot;
+        ++open;
+        armReceive(*connections[slot]);
+    }
+
+    void received(Connection &connection, const io_uring_cqe &completion) {
+        if (completion.flags & IORING_CQE_F_BUFFER) {
+            unsigned id = completion.flags >> IORING_CQE_BUFFER_SHIFT;
+            if (!connection.closed && completion.res > 0) {
+                const char *data = bufferMemory.data() + std::size_t(id) * receiveBufferSize;
+                bool valid = connection.reader.append(data, static_cast<std::size_t>(completion.res)) &&
+                             protocol.handle(static_cast<int>(connection.slot), connection.reader, connection.outbound);
+                if (!valid) close(connection);
+                else if (!connection.outbound.empty()) markDirty(connection);
+            }
+            returnBuffer(id);
+        }
+        if (connection.closed) return;
+        if (completion.res == 0 || (completion.res < 0 && completion.res != -ENOBUFS)) {
+            close(connection); // Peer closed or the socket failed
+        } else if (!(completion.flags & IORING_CQE_F_MORE)) {
+            armReceive(connection); // Out of buffers for a moment, or the kernel ended the multishot
+        }
+    }
+
+    void sent(Connection &connection, int result) {
+        connection.sendInFlight = false;
+        if (connection.closed) return;
+        if (result < 0) {
+            close(connection);
+            return;
+        }
+        connection.sendingOffset += static_cast<std::size_t>(result);
+        if (connection.sendingOffset < connection.sending.size()) {
+            submitSend(connection);
+            return;
+        }
+        connection.sending.clear();
+        connection.sendingOffset = 0;
+        if (!connection.outbound.empty()) markDirty(connection);
+    }
+
+    void pushUpdates() {
+        protocol.forEachUpdate([this](const char *bytes, std::size_t length, const std::vector<int> &subscribers) {
+            for (int slot : subscribers) {
+                Connection &connection = *connections[slot];
+                connection.outbound.insert(connection.outbound.end(), bytes, bytes + length);
+                markDirty(connection);
+            }
+        });
+    }
+
+    void markDirty(Connection &connection) {
+        if (connection.dirty) return;
+        connection.dirty = true;
+        dirty.push_back(connection.slot);
+    }
+
+    // Queue one send per connection for everything produced this pass, the next wait submits them
+    void flush() {
+        for (unsigned slot : dirty) {
+            Connection *connection = connections[slot].get();
+            if (!connection) continue;
+            connection->dirty = false;
+            if (connection->closed || connection->outbound.empty()) continue;
+            if (connection->outbound.size() > maxOutbound) {
+                close(*connection);
+                continue;
+            }
+            if (connection->sendInFlight) continue; // Goes out when the current send completes
+            std::swap(connection->sending, connection->outbound);
+            submitSend(*connection);
+        }
+        dirty.clear();
+    }
+
+    // Cancel what is in flight, the slot is emptied once the cancel completes
+    void close(Connection &connection) {
+        if (connection.closed) return;
+        connection.closed = true;
+        protocol.disconnect(static_cast<int>(connection.slot));
+        io_uring_sqe &entry = ring.nextEntry();
+        entry.opcode = IORING_OP_ASYNC_CANCEL;
+        entry.fd = static_cast<int>(connection.slot);
+        entry.cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_FD_FIXED | IORING_ASYNC_CANCEL_ALL;
+        entry.user_data = tag(&connection, CancelOperation);
+        ++connection.inFlight;
+    }
+
+    void release(Connection &connection) {
+        unsigned slot = connection.slot;
+        connections[slot].reset();
+        freeSlots.push_back(slot);
+        --open;
+    }
+
+    void returnBuffer(unsigned id) {
+        // The entries start at the ring's first byte (bufs overlays the header, but the kernel's
+        // flexible array macro shifts it by 8 bytes when compiled as C++)
+        io_uring_buf &buffer = reinterpret_cast<io_uring_buf *>(bufferRing)[bufferTail & (receiveBuffers - 1)];
+        buffer.addr = reinterpret_cast<uint64_t>(bufferMemory.data() + std::size_t(id) * receiveBufferSize);
+        buffer.len = receiveBufferSize;
+        buffer.bid = static_cast<uint16_t>(id);
+        ++bufferTail;
+    }
+
+    // Hand the returned buffers back to the kernel in one store
+    void publishBuffers() {
+        __atomic_store_n(&bufferRing->tail, bufferTail, __ATOMIC_RELEASE);
+    }
+
+    std::vector<int> listeners;
+    std::vector<std::string> unixPaths;
+    std::vector<std::unique_ptr<Connection>> connections; // By fixed file slot
+    std::vector<unsigned> freeSlots;
+    std::vector<unsigned> dirty; // Slots with output this pass
+    io_uring_buf_ring *bufferRing = nullptr;
+    std::size_t bufferRingSize = 0;
+    std::vector<char> bufferMemory;
+    uint16_t bufferTail = 0;
+    std::size_t open = 0;
+    uint64_t extraCalls = 0; // accept bookkeeping outside the ring
+    Protocol protocol;
+    IoUring ring; // Last, so it is closed (cancelling what is in flight) before the buffers go
+};
@@ -0,0 +1,433 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "order_wire.h"
+#include "symbols.h"
+
+// Normalization of venue market data feeds into one internal update event
+// Every feed format is a tag type with a VenueCodec specialization chosen at compile time; a
+// MarketDataNormalizer<Feeds...> holds one VenueFeed per format, the venue id of a feed is its
+// position in the list, and hands the apply path nothing but MarketUpdate
+// A codec specialization provides:
+//     template <typename Emit>
+//     static std::size_t decode(const char *data, std::size_t length, VenueSymbolMap &symbols, Emit &&emit);
+//         size of the message at data, 0 while it is incomplete, notFramed when the stream is
+//         corrupt; calls emit(MarketUpdate &) (venue not set yet) for a price message of a mapped symbol
+//     static void encodeDefinition(uint32_t code, const std::string &name, std::vector<char> &out);
+//     static void encode(const MarketUpdate &update, uint32_t code, std::vector<char> &out);
+//         the other direction, for simulators and tests
+
+enum MarketUpdateKind : uint8_t {
+    MarketTrade = 1, // price and quantity are set
+    MarketQuote = 2, // bid, ask and their sizes are set, an empty side is 0
+};
+
+// One update of one symbol at one venue
+struct MarketUpdate {
+    SymbolId symbol;
+    uint16_t venue;
+    uint8_t kind;      // MarketUpdateKind bits
+    uint8_t reserved;
+    int64_t timestamp; // Venue time, nanoseconds since the epoch
+    double price;
+    int64_t quantity;
+    double bid;
+    double ask;
+    int64_t bidSize;
+    int64_t askSize;
+};
+static_assert(sizeof(MarketUpdate) == 64, "one cache line per update");
+
+constexpr std::size_t notFramed = ~std::size_t(0);
+
+// A venue's own instrument codes (locate codes, security ids) to interned symbol ids
+// Codes are learned from the feed's definition messages; codes of symbols this process doesn't
+// list map to invalidSymbol and their updates are dropped
+// Small codes (ITCH locates, listing order) index a vector; anything larger, like SBE security
+// ids that can be any 32 bit value, goes to a hash map so one definition can't size the vector
+class VenueSymbolMap {
+public:
+    static constexpr uint32_t denseCodes = 1 << 16;
+
+    explicit VenueSymbolMap(const SymbolTable &table) : table(&table) {}
+
+    void define(uint32_t code, const std::string &name) {
+        SymbolId id = table->find(name);
+        if (code < std::max<std::size_t>(denseCodes, byCode.size())) {
+            if (code >= byCode.size()) byCode.resize(code + 1, invalidSymbol);
+            byCode[code] = id;
+        } else if (id != invalidSymbol) {
+            sparse[code] = id;
+        } else {
+            sparse.erase(code);
+        }
+    }
+
+    // Feeds that already number symbols in listing order
+    void identity() {
+        byCode.resize(table->size());
+        for (SymbolId id = 0; id < byCode.size(); ++id) byCode[id] = id;
+    }
+
+    SymbolId find(uint32_t code) const {
+        if (code < byCode.size()) return byCode[code];
+        if (sparse.empty()) return invalidSymbol;
+        auto it = sparse.find(code);
+        return it == sparse.end() ? invalidSymbol : it->second;
+    }
+
+private:
+    const SymbolTable *table;
+    std::vector<SymbolId> byCode;
+    std::unordered_map<uint32_t, SymbolId> sparse; // Codes past the vector
+};
+
+template <typename Feed>
+struct VenueCodec; // Specialized per feed format, see above
+
+// The local matching engine's market data (order_wire.h): little endian, fixed point prices,
+// symbols already numbered in listing order
+struct ExchangeFeed {};
+
+template <>
+struct VenueCodec<ExchangeFeed> {
+    static void setup(VenueSymbolMap &symbols) { symbols.identity(); }
+
+    template <typename Emit>
+    static std::size_t decode(const char *data, std::size_t length, VenueSymbolMap &symbols, Emit &&emit) {
+        if (length < sizeof(WireHeader)) return 0;
+        WireHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.length < sizeof(WireHeader)) return notFramed;
+        if (length < header.length) return 0;
+        if (header.type == WireMarketDataType && header.length == sizeof(WireMarketData)) {
+            WireMarketData message;
+            std::memcpy(&message, data, sizeof(message));
+            MarketUpdate update;
+            if (normalize(message, symbols, update)) emit(update);
+        }
+        return header.length;
+    }
+
+    // For callers that already have the message decoded (the order gateway)
+    static bool normalize(const WireMarketData &message, const VenueSymbolMap &symbols, MarketUpdate &update) {
+        update = MarketUpdate{};
+        update.symbol = symbols.find(message.symbol);
+        update.timestamp = message.exchangeTime;
+        update.kind = MarketQuote;
+        update.bid = priceFromWire(message.bestBid);
+        update.ask = priceFromWire(message.bestAsk);
+        if (message.lastQuantity > 0) {
+            update.kind |= MarketTrade;
+            update.price = priceFromWire(message.lastPrice);
+            update.quantity = message.lastQuantity;
+        }
+        return update.symbol != invalidSymbol;
+    }
+
+    static void encodeDefinition(uint32_t, const std::string &, std::vector<char> &) {}
+
+    static void encode(const MarketUpdate &update, uint32_t code, std::vector<char> &out) {
+        WireMarketData message = makeWireMessage<WireMarketData>(WireMarketDataType);
+        message.symbol = code;
+        message.lastPrice = update.kind & MarketTrade ? priceToWire(update.price) : 0;
+        message.lastQuantity = update.kind & MarketTrade ? update.quantity : 0;
+        message.bestBid = priceToWire(update.bid);
+        message.bestAsk = priceToWire(update.ask);
+        message.exchangeTime = update.timestamp;
+        appendWireMessage(out, message);
+    }
+};
+
+// ITCH style: big endian, each message behind a 2 byte length, symbols by 2 byte locate code
+// from 'R' directory messages, prices as 4 decimal fixed point
+//     'R' locate:u16 symbol:char[8] (space padded)
+//     'P' locate:u16 timestamp:u64 shares:u32 price:u32                                trade
+//     'Q' locate:u16 timestamp:u64 bid:u32 bidShares:u32 ask:u32 askShares:u32          top of book
+struct ItchFeed {};
+
+template <>
+struct VenueCodec<ItchFeed> {
+    static void setup(VenueSymbolMap &) {}
+
+    template <typename Emit>
+    static std::size_t decode(const char *data, std::size_t length, VenueSymbolMap &symbols, Emit &&emit) {
+        if (length < 3) return 0;
+        std::size_t size = 2 + load16(data);
+        if (size < 3) return notFramed;
+        if (length < size) return 0;
+        const char *body = data + 3;
+        char type = data[2];
+        MarketUpdate update{};
+        if (type == 'R' && size >= 3 + 10) {
+            std::string name(body + 2, 8);
+            name.erase(name.find_last_not_of(' ') + 1);
+            symbols.define(load16(body), name);
+            return size;
+        } else if (type == 'P' && size >= 3 + 18) {
+            update.kind = MarketTrade;
+            update.quantity = load32(body + 10);
+            update.price = load32(body + 14) / wirePriceScale;
+        } else if (type == 'Q' && size >= 3 + 26) {
+            update.kind = MarketQuote;
+            update.bid = load32(body + 10) / wirePriceScale;
+            update.bidSize = load32(body + 14);
+            update.ask = load32(body + 18) / wirePriceScale;
+            update.askSize = load32(body + 22);
+        } else {
+            return size; // A message type this feed doesn't need
+        }
+        update.symbol = symbols.find(load16(body));
+        update.timestamp = static_cast<int64_t>(load64(body + 2));
+        if (update.symbol != invalidSymbol) emit(update);
+        return size;
+    }
+
+    static void encodeDefinition(uint32_t code, const std::string &name, std::vector<char> &out) {
+        char padded[8];
+        std::memset(padded, ' ', sizeof(padded));
+        std::memcpy(padded, name.data(), std::min(name.size(), sizeof(padded)));
+        store(out, uint16_t(11));
+        out.push_back('R');
+        store(out, static_cast<uint16_t>(code));
+        out.insert(out.end(), padded, padded + sizeof(padded));
+    }
+
+    // A trade and quote update becomes two messages
+    static void encode(const MarketUpdate &update, uint32_t code, std::vector<char> &out) {
+        if (update.kind & MarketTrade) {
+            store(out, uint16_t(19));
+            out.push_back('P');
+            store(out, static_cast<uint16_t>(code));
+            store(out, static_cast<uint64_t>(update.timestamp));
+            store(out, static_cast<uint32_t>(update.quantity));
+            store(out, static_cast<uint32_t>(priceToWire(update.price)));
+        }
+        if (update.kind & MarketQuote) {
+            store(out, uint16_t(27));
+            out.push_back('Q');
+            store(out, static_cast<uint16_t>(code));
+            store(out, static_cast<uint64_t>(update.timestamp));
+            store(out, static_cast<uint32_t>(priceToWire(update.bid)));
+            store(out, static_cast<uint32_t>(update.bidSize));
+            store(out, static_cast<uint32_t>(priceToWire(update.ask)));
+            store(out, static_cast<uint32_t>(update.askSize));
+        }
+    }
+
+private:
+    static uint16_t load16(const char *p) { uint16_t v; std::memcpy(&v, p, 2); return __builtin_bswap16(v); }
+    static uint32_t load32(const char *p) { uint32_t v; std::memcpy(&v, p, 4); return __builtin_bswap32(v); }
+    static uint64_t load64(const char *p) { uint64_t v; std::memcpy(&v, p, 8); return __builtin_bswap64(v); }
+
+    template <typename T>
+    static void store(std::vector<char> &out, T value) {
+        if constexpr (sizeof(T) == 2) value = __builtin_bswap16(value);
+        else if constexpr (sizeof(T) == 4) value = __builtin_bswap32(value);
+        else value = __builtin_bswap64(value);
+        const char *bytes = reinterpret_cast<const char *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+};
+
+// SBE style: little endian, each message behind the standard 8 byte SBE header, symbols by 4 byte
+// security id from definition messages, prices as decimal mantissa with a per message exponent
+struct SbeFeed {};
+
+template <>
+struct VenueCodec<SbeFeed> {
+    enum Template : uint16_t { DefinitionTemplate = 1, TradeTemplate = 2, BookTemplate = 3 };
+    static constexpr uint16_t schema = 7;
+
+    struct MessageHeader {
+        uint16_t blockLength; // Body bytes after this header
+        uint16_t templateId;
+        uint16_t schemaId;
+        uint16_t version;
+    };
+
+    struct Definition {
+        uint32_t securityId;
+        char symbol[16];       // Zero padded
+    };
+
+    struct Trade {
+        uint32_t securityId;
+        int8_t exponent;
+        uint8_t padding[3];
+        int64_t timestamp;
+        int64_t price;
+        int64_t quantity;
+    };
+
+    struct Book {
+        uint32_t securityId;
+        int8_t exponent;
+        uint8_t padding[3];
+        int64_t timestamp;
+        int64_t bid;
+        int64_t bidQuantity;
+        int64_t ask;
+        int64_t askQuantity;
+    };
+
+    static constexpr int8_t priceExponent = -6; // What encode uses
+
+    static void setup(VenueSymbolMap &) {}
+
+    template <typename Emit>
+    static std::size_t decode(const char *data, std::size_t length, VenueSymbolMap &symbols, Emit &&emit) {
+        if (length < sizeof(MessageHeader)) return 0;
+        MessageHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        std::size_t size = sizeof(MessageHeader) + header.blockLength;
+        if (length < size) return 0;
+        if (header.schemaId != schema) return size;
+        const char *body = data + sizeof(MessageHeader);
+        MarketUpdate update{};
+        uint32_t securityId;
+        if (header.templateId == DefinitionTemplate && header.blockLength >= sizeof(Definition)) {
+            Definition definition;
+            std::memcpy(&definition, body, sizeof(definition));
+            symbols.define(definition.securityId, std::string(definition.symbol, strnlen(definition.symbol, sizeof(definition.symbol))));
+            return size;
+        } else if (header.templateId == TradeTemplate && header.blockLength >= sizeof(Trade)) {
+            Trade trade;
+            std::memcpy(&trade, body, sizeof(trade));
+            if (!knownExponent(trade.exponent)) return size; // Corrupt, its price can't be trusted
+            double scale = powerOfTen(trade.exponent);
+            securityId = trade.securityId;
+            update.kind = MarketTrade;
+            update.timestamp = trade.timestamp;
+            update.price = trade.price * scale;
+            update.quantity = trade.quantity;
+        } else if (header.templateId == BookTemplate && header.blockLength >= sizeof(Book)) {
+            Book book;
+            std::memcpy(&book, body, sizeof(book));
+            if (!knownExponent(book.exponent)) return size;
+            double scale = powerOfTen(book.exponent);
+            securityId = book.securityId;
+            update.kind = MarketQuote;
+            update.timestamp = book.timestamp;
+            update.bid = book.bid * scale;
+            update.bidSize = book.bidQuantity;
+            update.ask = book.ask * scale;
+            update.askSize = book.askQuantity;
+        } else {
+            return size;
+        }
+        update.symbol = symbols.find(securityId);
+        if (update.symbol != invalidSymbol) emit(update);
+        return size;
+    }
+
+    static void encodeDefinition(uint32_t code, const std::string &name, std::vector<char> &out) {
+        Definition definition{};
+        definition.securityId = code;
+        std::memcpy(definition.symbol, name.data(), std::min(name.size(), sizeof(definition.symbol)));
+        append(out, DefinitionTemplate, definition);
+    }
+
+    static void encode(const MarketUpdate &update, uint32_t code, std::vector<char> &out) {
+        double scale = powerOfTen(-priceExponent);
+        if (update.kind & MarketTrade) {
+            Trade trade{code, priceExponent, {}, update.timestamp, std::llround(update.price * scale), update.quantity};
+            append(out, TradeTemplate, trade);
+        }
+        if (update.kind & MarketQuote) {
+            Book book{code, priceExponent, {}, update.timestamp, std::llround(update.bid * scale), update.bidSize,
+                      std::llround(update.ask * scale), update.askSize};
+            append(out, BookTemplate, book);
+        }
+    }
+
+private:
+    static bool knownExponent(int exponent) { return exponent >= -18 && exponent <= 18; }
+
+    // exponent in [-18, 18]
+    static double powerOfTen(int exponent) {
+        static const double table[] = {1e-18, 1e-17, 1e-16, 1e-15, 1e-14, 1e-13, 1e-12, 1e-11, 1e-10, 1e-9,
+                                       1e-8, 1e-7, 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3,
+                                       1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                       1e16, 1e17, 1e18};
+        return table[exponent + 18];
+    }
+
+    template <typename Body>
+    static void append(std::vector<char> &out, uint16_t templateId, const Body &body) {
+        MessageHeader header{static_cast<uint16_t>(sizeof(Body)), templateId, schema, 1};
+        const char *bytes = reinterpret_cast<const char *>(&header);
+        out.insert(out.end(), bytes, bytes + sizeof(header));
+        bytes = reinterpret_cast<const char *>(&body);
+        out.insert(out.end(), bytes, bytes + sizeof(body));
+    }
+};
+
+// One venue's stream: its symbol mapping and its codec
+template <typename Feed>
+class VenueFeed {
+public:
+    VenueFeed(uint16_t venue, const SymbolTable &table) : venue(venue), symbols(table) { VenueCodec<Feed>::setup(symbols); }
+
+    // Decodes every complete message in [data, data + length), calls emit(const MarketUpdate &) for
+    // each update and returns the bytes used (notFramed once the stream is corrupt)
+    template <typename Emit>
+    std::size_t decode(const char *data, std::size_t length, Emit &&emit) {
+        std::size_t used = 0;
+        while (used < length) {
+            std::size_t size = VenueCodec<Feed>::decode(data + used, length - used, symbols, [&](MarketUpdate &update) {
+                update.venue = venue;
+                emit(static_cast<const MarketUpdate &>(update));
+            });
+            if (size == notFramed) return notFramed;
+            if (size == 0) break;
+            used += size;
+            ++messages;
+        }
+        return used;
+    }
+
+    VenueSymbolMap &symbolMap() { return symbols; }
+    uint16_t id() const { return venue; }
+    uint64_t messageCount() const { return messages; }
+
+private:
+    uint16_t venue;
+    VenueSymbolMap symbols;
+    uint64_t messages = 0;
+};
+
+// Every feed format the process reads, dispatched at compile time by format
+template <typename... Feeds>
+class MarketDataNormalizer {
+public:
+    static constexpr std::size_t venueCount = sizeof...(Feeds);
+
+    explicit MarketDataNormalizer(const SymbolTable &table) : feeds(makeFeeds(table, std::index_sequence_for<Feeds...>{})) {}
+
+    template <typename Feed>
+    VenueFeed<Feed> &feed() { return std::get<VenueFeed<Feed>>(feeds); }
+
+    // Decodes bytes of Feed's stream, see VenueFeed::decode
+    template <typename Feed, typename Emit>
+    std::size_t decode(const char *data, std::size_t length, Emit &&emit) {
+        return feed<Feed>().decode(data, length, std::forward<Emit>(emit));
+    }
+
+private:
+    template <std::size_t... I>
+    static std::tuple<VenueFeed<Feeds>...> makeFeeds(const SymbolTable &table, std::index_sequence<I...>) {
+        return std::tuple<VenueFeed<Feeds>...>(VenueFeed<Feeds>(static_cast<uint16_t>(I), table)...);
+    }
+
+    std::tuple<VenueFeed<Feeds>...> feeds;
+};
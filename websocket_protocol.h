@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "movers.h"
+#include "order_wire.h"
+#include "price_history.h"
+#include "query_protocol.h"
+#include "symbols.h"
+#include "text_codec.h"
+
+// JSON over WebSocket (RFC 6455) for dashboards, a protocol for the epoll server (query_server.h)
+// After the HTTP upgrade a client sends text frames
+//     {"subscribe":"AAPL"}   {"unsubscribe":"AAPL"}   {"get":"AAPL"}
+// and gets one text frame per price (subscribe and get answer with the current one right away)
+//     {"symbol":"AAPL","price":123.45,"timestamp":1700000000000000000,"seq":42}
+//     {"symbol":"AAPL","error":"no price"}    {"symbol":"XYZ","error":"unknown symbol"}
+// {"movers":"gainers"} (or "losers", "active") answers with that leaderboard (movers.h) as last
+// published, one frame rendered per published version
+//     {"movers":"gainers","version":7,"entries":[{"symbol":"AAPL","price":123.45,"change":0.0123,"ticks":42},...]}
+// A price is rendered once per change (numbers through text_codec.h, no streams) into a whole
+// frame cached by symbol; replies and pushes to every subscriber copy the cached bytes
+// Source is the query protocol's plus
+//     static const std::string &name(SymbolId);
+//     static bool movers(MoversSnapshot &out);   // false before the first publish
+
+constexpr std::size_t webSocketMaxPayload = 4096; // Longer client frames close the connection
+
+// SHA-1 (FIPS 180-4), only for the handshake's Sec-WebSocket-Accept
+inline std::array<uint8_t, 20> sha1(const std::string &message) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    std::string padded = message;
+    padded += static_cast<char>(0x80);
+    while (padded.size() % 64 != 56) padded += '\0';
+    uint64_t bits = static_cast<uint64_t>(message.size()) * 8;
+    for (int shift = 56; shift >= 0; shift -= 8) padded += static_cast<char>(bits >> shift);
+
+    auto rotate = [](uint32_t v, int n) { return (v << n) | (v >> (32 - n)); };
+    for (std::size_t chunk = 0; chunk < padded.size(); chunk += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; ++i) {
+            const auto *p = reinterpret_cast<const uint8_t *>(padded.data() + chunk + 4 * i);
+            w[i] = uint32_t(p[0]) << 24 | uint32_t(p[1]) << 16 | uint32_t(p[2]) << 8 | p[3];
+        }
+        for (int i = 16; i < 80; ++i) w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i) {
+            uint32_t f, k;
+            if (i < 20) f = (b & c) | (~b & d), k = 0x5A827999;
+            else if (i < 40) f = b ^ c ^ d, k = 0x6ED9EBA1;
+            else if (i < 60) f = (b & c) | (b & d) | (c & d), k = 0x8F1BBCDC;
+            else f = b ^ c ^ d, k = 0xCA62C1D6;
+            uint32_t next = rotate(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotate(b, 30);
+            b = a;
+            a = next;
+        }
+        h[0] += a, h[1] += b, h[2] += c, h[3] += d, h[4] += e;
+    }
+
+    std::array<uint8_t, 20> digest;
+    for (int i = 0; i < 20; ++i) digest[i] = static_cast<uint8_t>(h[i / 4] >> (24 - 8 * (i % 4)));
+    return digest;
+}
+
+inline std::string base64(const uint8_t *data, std::size_t length) {
+    static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    for (std::size_t i = 0; i < length; i += 3) {
+        uint32_t group = uint32_t(data[i]) << 16;
+        if (i + 1 < length) group |= uint32_t(data[i + 1]) << 8;
+        if (i + 2 < length) group |= data[i + 2];
+        out += alphabet[group >> 18 & 63];
+        out += alphabet[group >> 12 & 63];
+        out += i + 1 < length ? alphabet[group >> 6 & 63] : '=';
+        out += i + 2 < length ? alphabet[group & 63] : '=';
+    }
+    return out;
+}
+
+// Accept value of the handshake response for the client's Sec-WebSocket-Key
+inline std::string webSocketAccept(const std::string &key) {
+    auto digest = sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11");
+    return base64(digest.data(), digest.size());
+}
+
+// Unmasked server frame with the whole payload (no fragmentation)
+inline void appendWebSocketFrame(std::vector<char> &out, uint8_t opcode, const char *payload, std::size_t length) {
+    out.push_back(static_cast<char>(0x80 | opcode));
+    if (length < 126) {
+        out.push_back(static_cast<char>(length));
+    } else if (length < 65536) {
+        out.push_back(126);
+        out.push_back(static_cast<char>(length >> 8));
+        out.push_back(static_cast<char>(length));
+    } else {
+        out.push_back(127);
+        for (int shift = 56; shift >= 0; shift -= 8) out.push_back(static_cast<char>(uint64_t(length) >> shift));
+    }
+    out.insert(out.end(), payload, payload + length);
+}
+
+template <typename Source>
+class WebSocketProtocol {
+public:
+    enum Opcode : uint8_t { TextFrame = 1, BinaryFrame = 2, CloseFrame = 8, PingFrame = 9, PongFrame = 10 };
+
+    // Answers the handshake and every complete frame in reader by appending to out, false when
+    // the connection should be closed once out is sent
+    bool handle(int connection, WireReader &reader, std::vector<char> &out) {
+        bool open = true;
+        reader.consume([&](const char *data, std::size_t length) -> std::size_t {
+            std::size_t used = 0;
+            if (!upgraded[connection]) {
+                used = handshake(data, length, out, open);
+                if (!open || used == 0) return used;
+                upgraded[connection] = true;
+            }
+            while (open) {
+                std::size_t frame = onFrame(connection, data + used, length - used, out, open);
+                if (frame == 0) break;
+                used += frame;
+            }
+            return used;
+        });
+        return open;
+    }
+
+    void disconnect(int connection) {
+        upgraded.erase(connection);
+        subscriptions.disconnect(connection);
+    }
+
+    // Calls fn(const char *bytes, std::size_t length, const std::vector<int> &connections) for every
+    // subscribed symbol whose price changed since the last call, bytes is the cached frame
+    template <typename Fn>
+    void forEachUpdate(Fn &&fn) {
+        subscriptions.forEachChanged([&](SymbolId symbol, const std::vector<int> &connections) {
+            const std::vector<char> &frame = priceFrame(symbol);
+            fn(frame.data(), frame.size(), connections);
+        });
+    }
+
+    // Price frames rendered so far, each one is shared by every connection that gets it
+    uint64_t framesRendered() const { return rendered; }
+
+private:
+    struct CachedFrame {
+        uint64_t seq = ~uint64_t(0);
+        std::vector<char> bytes;
+    };
+
+    // Reads the HTTP upgrade request, returns the bytes it used (0 while incomplete)
+    static std::size_t handshake(const char *data, std::size_t length, std::vector<char> &out, bool &open) {
+        std::string request(data, length);
+        std::size_t end = request.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            open = length < webSocketMaxPayload;
+            return 0;
+        }
+        std::string key;
+        for (std::size_t line = request.find("\r\n") + 2; line < end;) {
+            std::size_t next = request.find("\r\n", line);
+            std::size_t colon = request.find(':', line);
+            if (colon < next) {
+                std::string name = request.substr(line, colon - line);
+                for (char &c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+                std::size_t value = request.find_first_not_of(' ', colon + 1);
+                if (name == "sec-websocket-key" && value < next) key = request.substr(value, request.find_last_not_of(' ', next - 1) + 1 - value);
+            }
+            line = next + 2;
+        }
+        std::string reply;
+        if (request.compare(0, 4, "GET ") != 0 || key.empty()) {
+            reply = "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            open = false;
+        } else {
+            reply = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: " + webSocketAccept(key) + "\r\n\r\n";
+        }
+        out.insert(out.end(), reply.begin(), reply.end());
+        return end + 4;
+    }
+
+    // Handles one client frame, returns its length (0 while incomplete)
+    std::size_t onFrame(int connection, const char *data, std::size_t length, std::vector<char> &out, bool &open) {
+        if (length < 2) return 0;
+        auto *bytes = reinterpret_cast<const uint8_t *>(data);
+        bool final = bytes[0] & 0x80;
+        uint8_t opcode = bytes[0] & 0x0F;
+        uint64_t payload = bytes[1] & 0x7F;
+        std::size_t header = 2;
+        if (payload == 126) {
+            if (length < 4) return 0;
+            payload = uint64_t(bytes[2]) << 8 | bytes[3];
+            header = 4;
+        } else if (payload == 127) {
+            if (length < 10) return 0;
+            payload = 0;
+            for (int i = 2; i < 10; ++i) payload = payload << 8 | bytes[i];
+            header = 10;
+        }
+        // Clients must mask; fragmented and binary messages aren't part of this protocol
+        bool known = opcode == TextFrame || opcode == CloseFrame || opcode == PingFrame || opcode == PongFrame;
+        if (!(bytes[1] & 0x80) || !final || !known || payload > webSocketMaxPayload) {
+            closeWith(1002, out, open);
+            return length;
+        }
+        if (length < header + 4 + payload) return 0;
+        const uint8_t *mask = bytes + header;
+        std::string text(static_cast<std::size_t>(payload), '\0');
+        for (std::size_t i = 0; i < text.size(); ++i) text[i] = static_cast<char>(bytes[header + 4 + i] ^ mask[i % 4]);
+
+        if (opcode == TextFrame) onRequest(connection, text, out);
+        else if (opcode == PingFrame) appendWebSocketFrame(out, PongFrame, text.data(), text.size());
+        else if (opcode == CloseFrame) closeWith(1000, out, open);
+        return header + 4 + static_cast<std::size_t>(payload);
+    }
+
+    static void closeWith(uint16_t status, std::vector<char> &out, bool &open) {
+        char code[2] = {static_cast<char>(status >> 8), static_cast<char>(status)};
+        appendWebSocketFrame(out, CloseFrame, code, sizeof(code));
+        open = false;
+    }
+
+    // {"action":"SYMBOL"} with no escapes, anything else is answered with an error
+    void onRequest(int connection, const std::string &text, std::vector<char> &out) {
+        std::string action, name;
+        static const char badRequest[] = "{\"error\":\"bad request\"}";
+        bool parsed = parseRequest(text, action, name);
+        if (parsed && action == "movers") {
+            int board = name == "gainers" ? TopGainers : name == "losers" ? TopLosers : name == "active" ? MostActive : -1;
+            if (board >= 0) {
+                const std::vector<char> &frame = moversFrame(static_cast<MoversBoard>(board), name);
+                out.insert(out.end(), frame.begin(), frame.end());
+                return;
+            }
+        }
+        if (!parsed || (action != "subscribe" && action != "unsubscribe" && action != "get")) {
+            appendWebSocketFrame(out, TextFrame, badRequest, sizeof(badRequest) - 1);
+            return;
+        }
+        SymbolId symbol = Source::find(name);
+        if (symbol == invalidSymbol || symbol >= Source::symbolCount()) {
+            std::string error = "{\"symbol\":\"" + jsonEscape(name) + "\",\"error\":\"unknown symbol\"}";
+            appendWebSocketFrame(out, TextFrame, error.data(), error.size());
+            return;
+        }
+        if (action != "get") subscriptions.update(connection, symbol, action == "subscribe");
+        if (action == "unsubscribe") return;
+        const std::vector<char> &frame = priceFrame(symbol);
+        out.insert(out.end(), frame.begin(), frame.end());
+    }
+
+    static bool parseRequest(const std::string &text, std::string &action, std::string &name) {
+        std::size_t i = 0;
+        auto skipSpace = [&] { while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i]))) ++i; };
+        auto expect = [&](char c) {
+            skipSpace();
+            if (i >= text.size() || text[i] != c) return false;
+            ++i;
+            return true;
+        };
+        auto readString = [&](std::string &out) {
+            if (!expect('"')) return false;
+            std::size_t close = text.find('"', i);
+            if (close == std::string::npos || text.find('\\', i) < close) return false;
+            out = text.substr(i, close - i);
+            i = close + 1;
+            return true;
+        };
+        if (!expect('{') || !readString(action) || !expect(':') || !readString(name) || !expect('}')) return false;
+        skipSpace();
+        return i == text.size();
+    }
+
+    static std::string jsonEscape(const std::string &text) {
+        std::string out;
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                out += escaped;
+            } else {
+                out += c;
+            }
+        }
+        return out;
+    }
+
+    // The symbol's current price frame, rendered again only when the price changed
+    const std::vector<char> &priceFrame(SymbolId symbol) {
+        if (symbol >= frames.size()) frames.resize(Source::symbolCount());
+        CachedFrame &cached = frames[symbol];
+        uint64_t seq = Source::lastSeq(symbol);
+        if (cached.seq == seq) return cached.bytes;
+
+        PriceTick tick;
+        json.assign("{\"symbol\":\"").append(Source::name(symbol)); // Listed names need no escaping
+        if (Source::latest(symbol, tick)) {
+            json.append("\",\"price\":");
+            appendDouble(json, tick.price);
+            json.append(",\"timestamp\":");
+            appendInteger(json, tick.timestamp);
+            json.append(",\"seq\":");
+            appendInteger(json, tick.seq);
+            json.append("}");
+            seq = tick.seq;
+        } else {
+            json.append("\",\"error\":\"no price\"}");
+        }
+        cached.seq = seq;
+        cached.bytes.clear();
+        appendWebSocketFrame(cached.bytes, TextFrame, json.data(), json.size());
+        ++rendered;
+        return cached.bytes;
+    }
+
+    // The board's frame as of the last published snapshot, rendered again only for a new version
+    const std::vector<char> &moversFrame(MoversBoard board, const std::string &name) {
+        CachedFrame &cached = moverFrames[board];
+        if (!Source::movers(movers)) movers.version = 0;
+        if (cached.seq == movers.version) return cached.bytes;
+
+        json.assign("{\"movers\":\"").append(name).append("\",\"version\":");
+        appendInteger(json, movers.version);
+        json.append(",\"entries\":[");
+        for (uint32_t i = 0; i < movers.counts[board]; ++i) {
+            const Mover &mover = movers.boards[board][i];
+            json.append(i ? ",{\"symbol\":\"" : "{\"symbol\":\"").append(Source::name(mover.symbol));
+            json.append("\",\"price\":");
+            appendDouble(json, mover.price);
+            json.append(",\"change\":");
+            appendDouble(json, mover.change);
+            json.append(",\"ticks\":");
+            appendInteger(json, mover.ticks);
+            json.append("}");
+        }
+        json.append("]}");
+        cached.seq = movers.version;
+        cached.bytes.clear();
+        appendWebSocketFrame(cached.bytes, TextFrame, json.data(), json.size());
+        return cached.bytes;
+    }
+
+    std::unordered_map<int, bool> upgraded; // By connection, handshake done
+    Subscriptions<Source> subscriptions;
+    std::vector<CachedFrame> frames;        // By symbol id
+    CachedFrame moverFrames[moversBoardCount];
+    MoversSnapshot movers;                  // Scratch copy of the published boards
+    std::string json;                       // Scratch for rendering, keeps its capacity
+    uint64_t rendered = 0;
+};